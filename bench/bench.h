@@ -0,0 +1,11 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QStringList>
+
+// 各基准的入口: args 为程序名之后去掉子命令的参数 (args[0] 为 "voicephone-bench <子命令>")，返回退出码
+int runVoiceIoBench(const QStringList &args);
+int runControlBench(const QStringList &args);
+int runCryptoBench(const QStringList &args);
+
+#endif // BENCH_H
@@ -0,0 +1,145 @@
+#include "bench.h"
+#include "../src/controlcodec.h"
+#include "../src/crypto.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+#include <cstdio>
+
+/*
+ * 控制消息编码基准
+ *
+ * 对几种有代表性的服务器消息，分别按两种线上格式编码和解码 (均使用会话密钥的AES-256-CBC):
+ *   json    JSON (紧凑) -> CBC -> Base64
+ *   binary  ControlCodec -> CBC，前面加1字节标志
+ * 报告每条消息的帧长度 (不含长度前缀) 以及编码、解码每条消息的耗时。
+ */
+
+namespace {
+
+struct Sample {
+    const char *name;
+    QJsonObject message;
+};
+
+QString hexKey()
+{
+    return QString::fromUtf8(CryptoUtils::generateAESKey().toHex());
+}
+
+QVector<Sample> samples(int users)
+{
+    QJsonObject login;
+    login["type"] = "login_success";
+    login["voice_port"] = 8889;
+    login["session_id"] = QString::fromUtf8(CryptoUtils::generateSessionToken().toHex());
+    login["session_key"] = hexKey();
+    login["voice_id"] = 1234;
+    login["encoding"] = "binary";
+    login["presence"] = "delta";
+    login["resume_ticket"] = QString::fromUtf8(CryptoUtils::generateSessionToken().toHex());
+    login["resume_grace"] = 30;
+    login["channel"] = "General";
+    login["channel_key"] = hexKey();
+
+    QJsonArray names;
+    for (int i = 0; i < users; ++i) {
+        names.append(QString("user%1").arg(i));
+    }
+    QJsonObject userList;
+    userList["type"] = "user_list";
+    userList["channel"] = "General";
+    userList["users"] = names;
+    userList["version"] = 42;
+
+    QJsonObject presence;
+    presence["type"] = "presence_delta";
+    presence["channel"] = "General";
+    presence["from_version"] = 41;
+    presence["version"] = 42;
+    presence["joined"] = QJsonArray{ "alice", "bob" };
+    presence["left"] = QJsonArray{ "carol" };
+
+    return { { "login_success", login }, { "user_list", userList }, { "presence_delta", presence } };
+}
+
+QByteArray encodeJson(AesContext &cipher, const QJsonObject &message)
+{
+    return cipher.encryptCBC(QJsonDocument(message).toJson(QJsonDocument::Compact)).toBase64();
+}
+
+QJsonObject decodeJson(AesContext &cipher, const QByteArray &frame)
+{
+    return QJsonDocument::fromJson(cipher.decryptCBC(QByteArray::fromBase64(frame))).object();
+}
+
+QByteArray encodeBinary(AesContext &cipher, const QJsonObject &message)
+{
+    QByteArray frame = cipher.encryptCBC(ControlCodec::encode(message));
+    frame.prepend(char(ControlCodec::FLAG_ENCRYPTED));
+    return frame;
+}
+
+QJsonObject decodeBinary(AesContext &cipher, const QByteArray &frame)
+{
+    QJsonObject message;
+    ControlCodec::decode(cipher.decryptCBC(frame.sliced(1)), &message);
+    return message;
+}
+
+template <typename Fn>
+double nsPerCall(int iterations, Fn fn)
+{
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    return double(clock.nsecsElapsed()) / iterations;
+}
+
+} // namespace
+
+int runControlBench(const QStringList &args)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares JSON+Base64 and ControlCodec framing of encrypted control messages.");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption("iterations", "Encode/decode calls per message and format (default: 20000)",
+                                        "n", "20000");
+    QCommandLineOption usersOption("users", "Members in the user_list message (default: 20)", "n", "20");
+    parser.addOptions({ iterationsOption, usersOption });
+    parser.process(args);
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    AesContext cipher(CryptoUtils::generateAESKey());
+
+    std::printf("%-16s %-8s %8s %14s %14s\n", "message", "format", "bytes", "encode ns/msg", "decode ns/msg");
+    int failures = 0;
+    for (const Sample &sample : samples(qMax(0, parser.value(usersOption).toInt()))) {
+        const QByteArray json = encodeJson(cipher, sample.message);
+        const QByteArray binary = encodeBinary(cipher, sample.message);
+        if (decodeJson(cipher, json) != sample.message || decodeBinary(cipher, binary) != sample.message) {
+            std::fprintf(stderr, "%s: round trip mismatch\n", sample.name);
+            failures++;
+            continue;
+        }
+
+        // 结果的长度累加到 sink，避免编译器省略调用
+        qsizetype sink = 0;
+        const double jsonEncode = nsPerCall(iterations, [&]() { sink += encodeJson(cipher, sample.message).size(); });
+        const double jsonDecode = nsPerCall(iterations, [&]() { sink += decodeJson(cipher, json).size(); });
+        const double binaryEncode = nsPerCall(iterations, [&]() { sink += encodeBinary(cipher, sample.message).size(); });
+        const double binaryDecode = nsPerCall(iterations, [&]() { sink += decodeBinary(cipher, binary).size(); });
+
+        std::printf("%-16s %-8s %8lld %14.0f %14.0f\n", sample.name, "json",
+                    static_cast<long long>(json.size()), jsonEncode, jsonDecode);
+        std::printf("%-16s %-8s %8lld %14.0f %14.0f\n", sample.name, "binary",
+                    static_cast<long long>(binary.size()), binaryEncode, binaryDecode);
+        if (sink == 0) std::printf("\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
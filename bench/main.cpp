@@ -0,0 +1,46 @@
+#include "bench.h"
+#include <QCoreApplication>
+#include <cstdio>
+
+struct BenchCommand {
+    const char *name;
+    const char *description;
+    int (*run)(const QStringList &args);
+};
+
+static const BenchCommand COMMANDS[] = {
+    { "voice-io", "voice socket backends (qt / batched / uring) over loopback", runVoiceIoBench },
+    { "control", "control message framing: JSON+Base64 vs ControlCodec, both AES-CBC", runControlBench },
+    { "crypto", "one-shot AES helpers vs a cached AesContext (CTR / CBC / GCM)", runCryptoBench },
+};
+
+static void printUsage()
+{
+    std::printf("Usage: voicephone-bench <benchmark> [options]\n\nBenchmarks:\n");
+    for (const BenchCommand &command : COMMANDS) {
+        std::printf("  %-10s %s\n", command.name, command.description);
+    }
+    std::printf("\nRun 'voicephone-bench <benchmark> --help' for the options of a benchmark.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("voicephone-bench");
+
+    QStringList args = app.arguments();
+    if (args.size() < 2) {
+        printUsage();
+        return 1;
+    }
+
+    const QString name = args.takeAt(1);
+    for (const BenchCommand &command : COMMANDS) {
+        if (name == QLatin1String(command.name)) {
+            args[0] += QLatin1Char(' ') + name;
+            return command.run(args);
+        }
+    }
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,165 @@
+#include "bench.h"
+#include "../server/voicetransport.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+ * 语音端口I/O后端基准
+ *
+ * 在回环接口上以转发服务器的负载驱动各后端: 一个发送线程以突发方式向被测端口发送数据包，
+ * 被测后端每收到一个包就转发给 fanout 个目标 (只接收不读取的回环套接字)。
+ * 报告每秒处理的数据包数以及每个数据包的接收/发送系统调用数 (来自后端自身的统计)。
+ */
+
+namespace {
+
+constexpr int BURST = 32; // 发送线程每发送这么多个包暂停一次，模拟多个客户端交错到达
+
+struct BenchResult {
+    QString backend;
+    quint64 received = 0;
+    double seconds = 0.0;
+    VoiceIoStats stats;
+};
+
+bool runBackend(VoiceIoBackend backend, quint16 port, int packets, int fanout, int payloadSize,
+                BenchResult *result)
+{
+    std::unique_ptr<VoiceTransport> transport(VoiceTransport::create(backend));
+    result->backend = transport->name();
+    if (!transport->bind(port, false)) {
+        std::fprintf(stderr, "%s: bind failed: %s\n", transport->name(),
+                     qPrintable(transport->errorString()));
+        return false;
+    }
+
+    std::vector<std::unique_ptr<QUdpSocket>> sinks;
+    QVector<VoiceDestination> destinations;
+    for (int i = 0; i < fanout; ++i) {
+        auto sink = std::make_unique<QUdpSocket>();
+        if (!sink->bind(QHostAddress::LocalHost, 0)) {
+            std::fprintf(stderr, "sink bind failed: %s\n", qPrintable(sink->errorString()));
+            return false;
+        }
+        VoiceEndpoint endpoint = VoiceEndpoint::fromAddress(QHostAddress::LocalHost, sink->localPort());
+        destinations.append(VoiceDestination::fromEndpoint(endpoint));
+        sinks.push_back(std::move(sink));
+    }
+
+    // 计时从收到第一个包到收到最后一个包，不包括等待结束的空闲时间
+    QElapsedTimer clock;
+    qint64 firstNs = -1;
+    qint64 lastNs = 0;
+    VoiceTransport *relay = transport.get();
+    transport->setReceiveHandler([&](const VoiceEndpoint &, const char *data, qsizetype size) {
+        lastNs = clock.nsecsElapsed();
+        if (firstNs < 0) firstNs = lastNs;
+        result->received++;
+        relay->send(data, size, destinations.constData(), destinations.size());
+    });
+    clock.start();
+
+    std::atomic<bool> senderDone{false};
+    std::thread sender([&]() {
+        QUdpSocket socket;
+        QByteArray packet(payloadSize, 'v');
+        for (int i = 0; i < packets; ++i) {
+            socket.writeDatagram(packet, QHostAddress::LocalHost, port);
+            if (i % BURST == BURST - 1) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        senderDone = true;
+    });
+
+    // 发送结束且 200ms 内没有再收到数据包时结束本轮
+    QEventLoop loop;
+    QTimer poll;
+    quint64 lastCount = 0;
+    int quietTicks = 0;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (senderDone && result->received == lastCount) {
+            if (++quietTicks >= 4) loop.quit();
+        } else {
+            quietTicks = 0;
+        }
+        lastCount = result->received;
+    });
+    poll.start(50);
+    loop.exec();
+    sender.join();
+
+    result->seconds = firstNs < 0 ? 0.0 : double(lastNs - firstNs) / 1e9;
+    result->stats = transport->stats();
+    transport->close();
+    return true;
+}
+
+double ratio(quint64 a, quint64 b)
+{
+    return b ? double(a) / double(b) : 0.0;
+}
+
+} // namespace
+
+int runVoiceIoBench(const QStringList &args)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Drives each voice I/O backend with a loopback forwarding load.");
+    parser.addHelpOption();
+    QCommandLineOption backendsOption("backends", "Comma-separated backends to run (default: qt,batched,uring)",
+                                      "list", "qt,batched,uring");
+    QCommandLineOption packetsOption("packets", "Packets sent per backend (default: 200000)", "n", "200000");
+    QCommandLineOption fanoutOption("fanout", "Destinations each packet is forwarded to (default: 8)", "n", "8");
+    QCommandLineOption sizeOption("size", "Payload size in bytes (default: 100)", "bytes", "100");
+    QCommandLineOption portOption("port", "Loopback port of the backend under test (default: 47890)", "port", "47890");
+    parser.addOptions({ backendsOption, packetsOption, fanoutOption, sizeOption, portOption });
+    parser.process(args);
+
+    const int packets = qMax(1, parser.value(packetsOption).toInt());
+    const int fanout = qMax(1, parser.value(fanoutOption).toInt());
+    const int payloadSize = qBound(1, parser.value(sizeOption).toInt(), VoiceBufferPool::BUFFER_SIZE);
+    const quint16 port = quint16(parser.value(portOption).toUInt());
+
+    std::printf("%d packets of %d bytes, each forwarded to %d destinations\n\n", packets, payloadSize, fanout);
+    std::printf("%-8s %10s %8s %12s %12s %12s %12s\n", "backend", "received", "loss",
+                "rx pkt/s", "rx sys/pkt", "tx pkt/s", "tx sys/pkt");
+
+    int failures = 0;
+    for (const QString &name : parser.value(backendsOption).split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        VoiceIoBackend backend = VoiceTransport::parseBackend(name.trimmed(), &ok);
+        if (!ok) {
+            std::fprintf(stderr, "unknown backend: %s\n", qPrintable(name));
+            failures++;
+            continue;
+        }
+
+        BenchResult result;
+        if (!runBackend(backend, port, packets, fanout, payloadSize, &result)) {
+            failures++;
+            continue;
+        }
+        // 不支持的后端会回退，按实际运行的后端报告
+        const VoiceIoStats &stats = result.stats;
+        std::printf("%-8s %10llu %7.2f%% %12.0f %12.3f %12.0f %12.3f\n",
+                    qPrintable(result.backend),
+                    static_cast<unsigned long long>(result.received),
+                    100.0 * (1.0 - ratio(result.received, quint64(packets))),
+                    result.seconds > 0 ? double(stats.packetsReceived) / result.seconds : 0.0,
+                    ratio(stats.receiveCalls, stats.packetsReceived),
+                    result.seconds > 0 ? double(stats.packetsSent) / result.seconds : 0.0,
+                    ratio(stats.sendCalls, stats.packetsSent));
+    }
+    return failures == 0 ? 0 : 1;
+}
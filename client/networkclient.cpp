@@ -1,18 +1,31 @@
 #include "networkclient.h"
+#include "../src/controlcodec.h"
 #include "../src/crypto.h"
 #include <QDebug>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QTimer>
+#include <utility>
+
+// 恢复会话时两次重连之间的间隔
+static constexpr int RESUME_RETRY_MS = 1000;
 
 NetworkClient::NetworkClient(QObject *parent)
-    : QObject(parent), m_socket(new QTcpSocket(this)),
-      m_isAuthenticated(false) {
+    : QObject(parent), m_socket(new QTcpSocket(this)), m_port(0),
+      m_parser(FrameParser::Mode::LengthPrefixed), m_flushScheduled(false),
+      m_isAuthenticated(false), m_binary(false), m_voiceId(0),
+      m_redirecting(false), m_resumeGrace(0), m_resuming(false),
+      m_resumeFallback(false), m_resumeTimer(new QTimer(this)),
+      m_presenceVersion(0) {
   connect(m_socket, &QTcpSocket::connected, this, &NetworkClient::onConnected);
   connect(m_socket, &QTcpSocket::disconnected, this,
           &NetworkClient::onDisconnected);
   connect(m_socket, &QTcpSocket::readyRead, this, &NetworkClient::onReadyRead);
   connect(m_socket, &QTcpSocket::errorOccurred, this, &NetworkClient::onError);
+  m_resumeTimer->setSingleShot(true);
+  connect(m_resumeTimer, &QTimer::timeout, this,
+          &NetworkClient::attemptResume);
 }
 
 NetworkClient::~NetworkClient() { disconnect(); }
@@ -23,16 +36,33 @@ void NetworkClient::connectToServer(const QString &host, quint16 port) {
   }
 
   qInfo() << "Connecting to server:" << host << ":" << port;
+  m_host = host;
+  m_port = port;
   m_socket->connectToHost(host, port);
 }
 
 void NetworkClient::disconnect() {
+  m_redirecting = false;
+  m_resumeFallback = false;
+  m_resumeTimer->stop();
   if (m_socket->state() == QAbstractSocket::ConnectedState) {
+    // 主动断开: 服务器立即释放会话，不再保留等待恢复
+    if (m_isAuthenticated) {
+      sendLogout();
+    }
+    m_resumeTicket.clear();
+    m_resuming = false;
+    flushOutput();
     m_socket->disconnectFromHost();
+  } else if (m_resuming) {
+    // 正在重连以恢复会话: 放弃恢复，按断开处理
+    abandonResume();
   }
   m_isAuthenticated = false;
+  m_binary = false;
   m_sessionId.clear();
   m_sessionKey.clear();
+  m_sessionCipher.clear();
   m_channelKey.clear();
 }
 
@@ -53,23 +83,47 @@ void NetworkClient::registerUser(const QString &username,
 
 void NetworkClient::login(const QString &username, const QString &password,
                           const QString &udpIp, quint16 udpPort) {
-  QByteArray passwordHash = CryptoUtils::hashPassword(password);
+  m_username = username;
+  m_passwordHash = CryptoUtils::hashPassword(password);
+  m_udpIp = udpIp;
+  m_udpPort = udpPort;
+  sendLogin();
+}
 
+void NetworkClient::sendLogin() {
   QJsonObject msg;
   msg["type"] = "login";
-  msg["username"] = username;
-  msg["password_hash"] = QString::fromUtf8(passwordHash.toHex());
-  msg["udp_ip"] = udpIp;
-  msg["udp_port"] = udpPort;
+  msg["username"] = m_username;
+  msg["password_hash"] = QString::fromUtf8(m_passwordHash.toHex());
+  msg["udp_ip"] = m_udpIp;
+  msg["udp_port"] = m_udpPort;
+  // 请求二进制控制消息编码，服务器在 login_success 中确认后生效
+  msg["encoding"] = "binary";
+  // 频道成员变化以合并后的版本化增量接收
+  msg["presence"] = "delta";
   sendMessage(msg);
-  m_username = username;
-  m_udpPort = udpPort;
+}
+
+void NetworkClient::sendLogout() {
+  // 随后就会断开连接，必须立即写出
+  QJsonObject msg;
+  msg["type"] = "logout";
+  sendEncryptedMessage(msg, true);
+  m_resumeTicket.clear();
 }
 
 void NetworkClient::joinChannel(const QString &channel) {
   QJsonObject msg;
   msg["type"] = "join_channel";
   msg["channel"] = channel;
+  if (channel == m_presenceChannel && m_presenceVersion > 0) {
+    // 重新加入同一频道: 服务器只需发送该版本之后的变化
+    msg["presence_version"] = qint64(m_presenceVersion);
+  } else {
+    m_presenceChannel = channel;
+    m_presenceVersion = 0;
+    m_presenceUsers.clear();
+  }
   sendEncryptedMessage(msg);
 }
 
@@ -87,29 +141,85 @@ void NetworkClient::requestChannelList() {
 
 void NetworkClient::onConnected() {
   qInfo() << "Connected to server";
+  // 消息已按事件循环合并写出，不需要 Nagle 算法再等待
+  m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+  // 编码在每条连接上重新协商: 登录、注册和恢复请求总是以JSON发送
+  m_binary = false;
+  if (m_resuming) {
+    QJsonObject msg;
+    msg["type"] = "resume";
+    msg["ticket"] = m_resumeTicket;
+    msg["udp_ip"] = m_udpIp;
+    msg["udp_port"] = m_udpPort;
+    msg["encoding"] = "binary";
+    msg["presence"] = "delta";
+    if (m_presenceVersion > 0) {
+      msg["presence_version"] = qint64(m_presenceVersion);
+    }
+    sendMessage(msg);
+    return;
+  }
+  if (m_redirecting) {
+    sendLogin();
+    return;
+  }
   emit connected();
 }
 
 void NetworkClient::onDisconnected() {
   qInfo() << "Disconnected from server";
-  m_buffer.clear();
+  m_parser = FrameParser(FrameParser::Mode::LengthPrefixed);
+  m_output.clear();
   m_isAuthenticated = false;
+  m_binary = false;
+  // 意外断开且持有恢复票据: 保留会话、频道密钥和成员列表，音频继续运行，
+  // 在宽限期内重新连接并恢复会话
+  if (!m_redirecting && !m_resumeTicket.isEmpty()) {
+    if (!m_resuming) {
+      qInfo() << "Connection lost - resuming session for up to"
+              << m_resumeGrace << "s";
+      m_resuming = true;
+      m_resumeDeadline = QDeadlineTimer(qint64(m_resumeGrace) * 1000);
+      m_resumeTimer->start(0);
+      emit connectionInterrupted();
+    } else {
+      scheduleResume();
+    }
+    return;
+  }
   m_sessionId.clear();
   m_sessionKey.clear();
+  m_sessionCipher.clear();
   m_channelKey.clear();
+  // 成员版本只在同一服务器的同一会话内有效
+  m_presenceChannel.clear();
+  m_presenceVersion = 0;
+  m_presenceUsers.clear();
+  // 重定向过程中保留登录信息，连接到新节点后自动重新登录
+  if (m_redirecting) {
+    return;
+  }
+  m_resuming = false;
+  m_channel.clear();
   m_voicePort = 0;
   m_udpPort = 0;
+  m_voiceId = 0;
+  m_passwordHash.clear();
   emit disconnected();
 }
 
 void NetworkClient::onReadyRead() {
-  m_buffer.append(m_socket->readAll());
+  m_parser.append(m_socket->readAll());
+
+  // 处理所有完整的消息（长度前缀分帧），不完整的部分留待下次读取
+  QByteArrayView frame;
+  while (m_parser.next(&frame)) {
+    if (m_binary) {
+      handleBinaryFrame(frame);
+      continue;
+    }
 
-  // 处理完整的消息（以换行符分隔）
-  int pos;
-  while ((pos = m_buffer.indexOf('\n')) != -1) {
-    QByteArray message = m_buffer.left(pos);
-    m_buffer.remove(0, pos + 1);
+    QByteArray message = QByteArray::fromRawData(frame.data(), frame.size());
 
     // 先尝试作为JSON明文解析
     QByteArray decryptedMessage = message;
@@ -120,8 +230,7 @@ void NetworkClient::onReadyRead() {
       // 尝试从Base64解码并解密
       QByteArray decoded = QByteArray::fromBase64(message);
       if (!decoded.isEmpty() && decoded.size() > 16) {
-        QByteArray decrypted =
-            CryptoUtils::decryptAES_CBC(decoded, m_sessionKey);
+        QByteArray decrypted = m_sessionCipher.decryptCBC(decoded);
         if (!decrypted.isEmpty()) {
           decryptedMessage = decrypted;
           doc = QJsonDocument::fromJson(decryptedMessage);
@@ -135,12 +244,54 @@ void NetworkClient::onReadyRead() {
       qWarning() << "Received invalid JSON message";
     }
   }
+
+  if (m_parser.hasError()) {
+    qWarning() << "Received oversized control frame, disconnecting";
+    m_socket->abort();
+  }
+}
+
+void NetworkClient::handleBinaryFrame(QByteArrayView frame) {
+  // [标志字节][ControlCodec消息]，设置 FLAG_ENCRYPTED 时消息为AES-CBC密文
+  if (frame.isEmpty()) {
+    qWarning() << "Received empty control frame";
+    return;
+  }
+  quint8 flags = quint8(frame.front());
+  QByteArray body =
+      QByteArray::fromRawData(frame.data() + 1, frame.size() - 1);
+  if (flags & ControlCodec::FLAG_ENCRYPTED) {
+    if (m_sessionKey.isEmpty()) {
+      qWarning() << "Received encrypted message without a session key";
+      return;
+    }
+    body = m_sessionCipher.decryptCBC(body);
+  }
+
+  QJsonObject obj;
+  if (!ControlCodec::decode(body, &obj)) {
+    qWarning() << "Received invalid binary control message";
+    return;
+  }
+  handleMessage(obj);
 }
 
 void NetworkClient::onError(QAbstractSocket::SocketError socketError) {
   Q_UNUSED(socketError);
   QString error = m_socket->errorString();
   qWarning() << "Socket error:" << error;
+  if (m_resuming || (!m_redirecting && !m_resumeTicket.isEmpty())) {
+    // 连接断开后转入会话恢复 (onDisconnected)；重连失败时稍后重试
+    if (m_resuming && m_socket->state() != QAbstractSocket::ConnectedState) {
+      scheduleResume();
+    }
+    return;
+  }
+  if (m_redirecting) {
+    // 无法连接到目标节点，按断开处理
+    m_redirecting = false;
+    onDisconnected();
+  }
   emit errorOccurred(error);
 }
 
@@ -150,17 +301,47 @@ void NetworkClient::handleMessage(const QJsonObject &obj) {
   if (type == "register_success") {
     emit registrationSuccess();
   } else if (type == "login_success") {
-    m_sessionId = obj["session_id"].toString();
-    m_sessionKey = QByteArray::fromHex(obj["session_key"].toString().toUtf8());
-    m_isAuthenticated = true;
-
-    quint16 voicePort = obj["voice_port"].toInt();
-    m_voicePort = voicePort;
-    emit loginSuccess(voicePort);
+    applySession(obj);
+    if (m_redirecting) {
+      // 已在新节点 (或恢复失败后在原服务器) 重新登录，继续加入原先的频道
+      m_redirecting = false;
+      if (m_resumeFallback) {
+        m_resumeFallback = false;
+        emit sessionResumed();
+      } else {
+        emit redirected(m_socket->peerName(), m_socket->peerPort());
+      }
+      if (!m_redirectChannel.isEmpty()) {
+        joinChannel(m_redirectChannel);
+      }
+      m_redirectChannel.clear();
+      return;
+    }
+    emit loginSuccess(quint16(m_voicePort));
+  } else if (type == "resume_success") {
+    // 服务器保留了会话、频道成员和语音发送者ID，音频引擎无需重启
+    applySession(obj);
+    m_resuming = false;
+    if (obj.contains("channel_key")) {
+      m_channelKey =
+          QByteArray::fromHex(obj["channel_key"].toString().toUtf8());
+    }
+    qInfo() << "Session resumed";
+    emit sessionResumed();
   } else if (type == "channel_list") {
     emit channelListReceived(obj);
   } else if (type == "user_list") {
+    if (obj.contains("version")) {
+      m_presenceChannel = obj["channel"].toString();
+      m_presenceVersion = quint64(obj["version"].toInteger());
+      m_presenceUsers.clear();
+      for (const QJsonValue &user : obj["users"].toArray()) {
+        m_presenceUsers.append(user.toString());
+      }
+    }
     emit userListReceived(obj);
+  } else if (type == "presence_delta") {
+    handlePresenceDelta(obj);
   } else if (type == "user_joined") {
     emit userJoined(obj["username"].toString());
   } else if (type == "user_left") {
@@ -174,29 +355,174 @@ void NetworkClient::handleMessage(const QJsonObject &obj) {
         qInfo() << "Received channel encryption key";
       }
     }
-    emit joinedChannel(obj["channel"].toString());
+    if (obj["channel"].toString() == m_presenceChannel &&
+        m_presenceVersion > 0) {
+      // 重新加入: 先恢复已知的成员列表，随后的增量在此基础上更新
+      QJsonObject list;
+      list["type"] = "user_list";
+      list["channel"] = m_presenceChannel;
+      list["users"] = QJsonArray::fromStringList(m_presenceUsers);
+      emit userListReceived(list);
+    }
+    m_channel = obj["channel"].toString();
+    emit joinedChannel(m_channel);
   } else if (type == "leave_success") {
     m_channelKey.clear();
+    m_channel.clear();
     emit leftChannel();
+  } else if (type == "redirect") {
+    followRedirect(obj);
   } else if (type == "error") {
+    if (m_resuming) {
+      // 恢复期间只发送了恢复请求
+      resumeRejected();
+      return;
+    }
+    m_redirecting = false;
+    m_resumeFallback = false;
     QString errorMsg = obj["message"].toString();
     emit errorOccurred(errorMsg);
   }
 }
 
-void NetworkClient::sendMessage(const QJsonObject &obj) {
+void NetworkClient::handlePresenceDelta(const QJsonObject &obj) {
+  if (obj["channel"].toString() != m_presenceChannel ||
+      quint64(obj["from_version"].toInteger()) != m_presenceVersion) {
+    // 增量不能接在已知状态之后: 丢弃并请求完整快照 (不重新加入频道，音频不受影响)；
+    // 等待快照期间 (版本为0) 到达的增量直接丢弃
+    qWarning() << "Presence delta does not follow the known version"
+               << m_presenceVersion << "- requesting a snapshot";
+    if (m_presenceVersion > 0 && !m_presenceChannel.isEmpty()) {
+      m_presenceVersion = 0;
+      QJsonObject msg;
+      msg["type"] = "get_user_list";
+      msg["channel"] = m_presenceChannel;
+      sendEncryptedMessage(msg);
+    }
+    return;
+  }
+  m_presenceVersion = quint64(obj["version"].toInteger());
+
+  for (const QJsonValue &user : obj["left"].toArray()) {
+    m_presenceUsers.removeOne(user.toString());
+    emit userLeft(user.toString());
+  }
+  for (const QJsonValue &user : obj["joined"].toArray()) {
+    m_presenceUsers.append(user.toString());
+    emit userJoined(user.toString());
+  }
+}
+
+void NetworkClient::applySession(const QJsonObject &obj) {
+  m_sessionId = obj["session_id"].toString();
+  m_sessionKey = QByteArray::fromHex(obj["session_key"].toString().toUtf8());
+  m_sessionCipher.setKey(m_sessionKey);
+  m_isAuthenticated = true;
+  m_voicePort = obj["voice_port"].toInt();
+  m_voiceId = quint16(obj["voice_id"].toInt());
+  // 本响应之后的消息均使用二进制编码
+  m_binary = obj["encoding"].toString() == "binary";
+  // 每次登录或恢复都会得到新的票据
+  m_resumeTicket = obj["resume_ticket"].toString();
+  m_resumeGrace = obj["resume_grace"].toInt();
+}
+
+void NetworkClient::attemptResume() {
+  if (!m_resuming) {
+    return;
+  }
+  if (m_resumeDeadline.hasExpired()) {
+    abandonResume();
+    return;
+  }
+  m_socket->abort();
+  m_socket->connectToHost(m_host, m_port);
+}
+
+void NetworkClient::scheduleResume() {
+  if (m_resumeDeadline.hasExpired()) {
+    abandonResume();
+    return;
+  }
+  m_resumeTimer->start(
+      int(qMin<qint64>(RESUME_RETRY_MS, m_resumeDeadline.remainingTime())));
+}
+
+void NetworkClient::resumeRejected() {
+  // 会话已过期或服务器不认识该票据 (例如服务器重启过): 用保存的登录信息重新登录，
+  // 之后加入原来的频道
+  qInfo() << "Session could not be resumed - logging in again";
+  m_resuming = false;
+  m_resumeTicket.clear();
+  m_sessionId.clear();
+  m_sessionKey.clear();
+  m_sessionCipher.clear();
+  m_channelKey.clear();
+  m_presenceChannel.clear();
+  m_presenceVersion = 0;
+  m_presenceUsers.clear();
+  if (m_passwordHash.isEmpty()) {
+    m_socket->disconnectFromHost();
+    return;
+  }
+  m_redirecting = true;
+  m_resumeFallback = true;
+  m_redirectChannel = m_channel;
+  sendLogin();
+}
+
+void NetworkClient::abandonResume() {
+  qWarning() << "Could not reconnect within the resume grace period";
+  m_resumeTimer->stop();
+  m_resuming = false;
+  m_resumeTicket.clear();
+  // 已连接时 abort 会发出 disconnected，否则直接按断开处理
+  bool wasConnected = m_socket->state() == QAbstractSocket::ConnectedState;
+  m_socket->abort();
+  if (!wasConnected) {
+    onDisconnected();
+  }
+}
+
+void NetworkClient::followRedirect(const QJsonObject &obj) {
+  QString host = obj["host"].toString();
+  quint16 port = quint16(obj["control_port"].toInt());
+  if (host.isEmpty() || port == 0 || m_passwordHash.isEmpty()) {
+    emit errorOccurred("Invalid redirect from server");
+    return;
+  }
+
+  qInfo() << "Channel" << obj["channel"].toString() << "is hosted on node"
+          << obj["node"].toString() << "- reconnecting to" << host << ":"
+          << port;
+  // 原节点上的会话不再需要保留
+  sendLogout();
+  m_redirecting = true;
+  m_redirectChannel = obj["channel"].toString();
+  m_host = host;
+  m_port = port;
+  m_socket->abort();
+  m_socket->connectToHost(host, port);
+}
+
+void NetworkClient::sendMessage(const QJsonObject &obj, bool immediate) {
   if (!isConnected()) {
     qWarning() << "Not connected to server";
     return;
   }
 
-  QByteArray data = QJsonDocument(obj).toJson(QJsonDocument::Compact);
-  data.append('\n');
-  m_socket->write(data);
-  m_socket->flush();
+  QByteArray data;
+  if (m_binary) {
+    data.append(char(0));
+    data.append(ControlCodec::encode(obj));
+  } else {
+    data = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+  }
+  queueFrame(data, immediate);
 }
 
-void NetworkClient::sendEncryptedMessage(const QJsonObject &obj) {
+void NetworkClient::sendEncryptedMessage(const QJsonObject &obj,
+                                         bool immediate) {
   if (!isConnected()) {
     qWarning() << "Not connected to server";
     return;
@@ -204,20 +530,54 @@ void NetworkClient::sendEncryptedMessage(const QJsonObject &obj) {
 
   // 如果未认证或没有会话密钥，发送明文
   if (!m_isAuthenticated || m_sessionKey.isEmpty()) {
-    sendMessage(obj);
+    sendMessage(obj, immediate);
+    return;
+  }
+
+  if (m_binary) {
+    QByteArray encrypted = m_sessionCipher.encryptCBC(ControlCodec::encode(obj));
+    if (!encrypted.isEmpty()) {
+      encrypted.prepend(char(ControlCodec::FLAG_ENCRYPTED));
+      queueFrame(encrypted, immediate);
+    }
     return;
   }
 
   QByteArray plaintext = QJsonDocument(obj).toJson(QJsonDocument::Compact);
-  QByteArray encrypted = CryptoUtils::encryptAES_CBC(plaintext, m_sessionKey);
+  QByteArray encrypted = m_sessionCipher.encryptCBC(plaintext);
 
   if (!encrypted.isEmpty()) {
     // 使用Base64编码加密数据以安全传输
-    QByteArray encoded = encrypted.toBase64();
-    encoded.append('\n');
-    m_socket->write(encoded);
-    m_socket->flush();
+    queueFrame(encrypted.toBase64(), immediate);
   } else {
     qWarning() << "Failed to encrypt message";
   }
 }
+
+void NetworkClient::queueFrame(const QByteArray &payload, bool immediate) {
+  m_output.append(
+      FrameParser::frame(payload, FrameParser::Mode::LengthPrefixed));
+  if (immediate) {
+    flushOutput();
+    return;
+  }
+  if (!m_flushScheduled) {
+    m_flushScheduled = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+          m_flushScheduled = false;
+          flushOutput();
+        },
+        Qt::QueuedConnection);
+  }
+}
+
+void NetworkClient::flushOutput() {
+  // 本轮的所有帧作为一块写出，一次系统调用
+  if (m_output.isEmpty() || !isConnected()) {
+    return;
+  }
+  m_socket->write(std::exchange(m_output, QByteArray()));
+  m_socket->flush();
+}
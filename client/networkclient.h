@@ -1,11 +1,18 @@
 #ifndef NETWORKCLIENT_H
 #define NETWORKCLIENT_H
 
+#include <QDeadlineTimer>
 #include <QJsonObject>
 #include <QObject>
+#include <QStringList>
 #include <QTcpSocket>
 #include <qobject.h>
 
+#include "../src/crypto.h"
+#include "../src/frameparser.h"
+
+class QTimer;
+
 class NetworkClient : public QObject {
   Q_OBJECT
 public:
@@ -20,6 +27,8 @@ public:
   QString getUsername() const { return m_username; }
   int getVoicePort() const { return m_voicePort; }
   int getUdpPort() const { return m_udpPort; }
+  // 服务器分配的语音发送者ID，写入每个语音数据包的头部
+  quint16 getVoiceId() const { return m_voiceId; }
 
   void registerUser(const QString &username, const QString &password);
   void login(const QString &username, const QString &password,
@@ -45,6 +54,12 @@ signals:
   void userLeft(const QString &username);
   void joinedChannel(const QString &channel);
   void leftChannel();
+  // 频道由集群中的其他节点负责，已切换到该节点 (随后会收到 joinedChannel)
+  void redirected(const QString &host, quint16 port);
+  // 控制连接意外断开，正在宽限期内重连以恢复会话 (音频不中断)
+  void connectionInterrupted();
+  // 会话已恢复 (或恢复失败后已重新登录，随后会收到 joinedChannel)
+  void sessionResumed();
   void errorOccurred(const QString &error);
 
 private slots:
@@ -55,18 +70,58 @@ private slots:
 
 private:
   void handleMessage(const QJsonObject &obj);
-  void sendMessage(const QJsonObject &obj);
-  void sendEncryptedMessage(const QJsonObject &obj);
+  void handleBinaryFrame(QByteArrayView frame);
+  void handlePresenceDelta(const QJsonObject &obj);
+  // immediate: 连同已排队的消息立即写出，否则在本轮事件循环结束时合并写出
+  void sendMessage(const QJsonObject &obj, bool immediate = false);
+  void sendEncryptedMessage(const QJsonObject &obj, bool immediate = false);
+  void queueFrame(const QByteArray &payload, bool immediate);
+  void flushOutput();
+  void sendLogin();
+  void sendLogout();
+  void applySession(const QJsonObject &obj);
+  void followRedirect(const QJsonObject &obj);
+  void attemptResume();
+  void scheduleResume();
+  void resumeRejected();
+  void abandonResume();
 
   QTcpSocket *m_socket;
-  QByteArray m_buffer;
+  QString m_host;
+  quint16 m_port;
+  FrameParser m_parser;
+  QByteArray m_output; // 本轮事件循环中排队、尚未写出的帧
+  bool m_flushScheduled;
   QString m_sessionId;
   QByteArray m_sessionKey;
+  AesContext m_sessionCipher; // 会话密钥的AES上下文，每条消息只重设IV
   QByteArray m_channelKey;
   bool m_isAuthenticated;
+  bool m_binary; // 登录时协商的二进制控制消息编码
   QString m_username;
   int m_voicePort;
   int m_udpPort;
+  quint16 m_voiceId;
+
+  // 登录信息，在集群重定向后向新节点重新登录
+  QByteArray m_passwordHash;
+  QString m_udpIp;
+  bool m_redirecting;
+  QString m_redirectChannel;
+  QString m_channel; // 当前所在的频道，恢复失败重新登录后再次加入
+
+  // 会话恢复: 连接意外断开后在宽限期内凭票据重新连接，无需重新登录和加入频道
+  QString m_resumeTicket;
+  int m_resumeGrace; // 秒
+  bool m_resuming;
+  bool m_resumeFallback; // 恢复被拒绝，正在重新登录
+  QDeadlineTimer m_resumeDeadline;
+  QTimer *m_resumeTimer;
+
+  // 频道成员状态 (服务器以版本化增量发送)，离开频道后保留，重新加入时只需之后的增量
+  QString m_presenceChannel;
+  quint64 m_presenceVersion;
+  QStringList m_presenceUsers;
 };
 
 #endif // NETWORKCLIENT_H
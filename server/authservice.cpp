@@ -0,0 +1,176 @@
+#include "authservice.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QThread>
+#include <QDebug>
+
+// 线程池中每个线程的数据库连接，线程退出时在该线程内关闭并移除
+struct ThreadConnection {
+    QString name;
+
+    ~ThreadConnection()
+    {
+        if (name.isEmpty()) return;
+        {
+            QSqlDatabase database = QSqlDatabase::database(name, false);
+            database.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+};
+
+static thread_local ThreadConnection t_connection;
+
+static QSqlDatabase threadDatabase(const QString &databasePath)
+{
+    if (t_connection.name.isEmpty()) {
+        QString name = QString("auth-%1").arg(quintptr(QThread::currentThread()), 0, 16);
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", name);
+        if (!UserDatabase::openDatabase(database, databasePath)) {
+            database = QSqlDatabase();
+            QSqlDatabase::removeDatabase(name);
+            return QSqlDatabase();
+        }
+        t_connection.name = name;
+    }
+    return QSqlDatabase::database(t_connection.name, false);
+}
+
+// 在线程池中执行，只访问本线程的连接
+static void runLogin(QSqlDatabase &database, AuthResult *result)
+{
+    QString username = result->request["username"].toString();
+    QByteArray passwordHash = QByteArray::fromHex(result->request["password_hash"].toString().toUtf8());
+
+    // 用户可能由集群中的其他节点注册或修改，登录时以数据库为准
+    UserCredentials user;
+    if (!UserDatabase::loadUser(database, username, &user)) {
+        qWarning() << "User not found:" << username;
+        return;
+    }
+    if (user.passwordHash != passwordHash) {
+        qWarning() << "Authentication failed for:" << username;
+        return;
+    }
+
+    // 更新最后登录时间
+    UserDatabase::updateLastLogin(database, username);
+    result->ok = true;
+    result->user = user;
+
+    QString userTypeStr = (user.userType == UserType::Administrator) ? "Admin" : "User";
+    qInfo() << "Authentication successful for:" << username << "(" << userTypeStr << ")";
+}
+
+static void runRegister(QSqlDatabase &database, AuthResult *result)
+{
+    UserCredentials user;
+    user.username = result->request["username"].toString();
+    user.passwordHash = QByteArray::fromHex(result->request["password_hash"].toString().toUtf8());
+    user.userType = UserType::User;
+    user.createdAt = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    if (user.username.isEmpty() || user.passwordHash.isEmpty()) {
+        qWarning() << "Invalid username or password hash";
+        return;
+    }
+
+    // 用户名的唯一约束由数据库保证
+    if (!UserDatabase::insertUser(database, user)) {
+        return;
+    }
+    result->ok = true;
+    result->user = user;
+    qInfo() << "User registered:" << user.username << "Type: User";
+}
+
+AuthService::AuthService(QObject *parent)
+    : QObject(parent)
+{
+    // 线程不过期，每个线程的数据库连接一直复用
+    m_pool.setExpiryTimeout(-1);
+}
+
+AuthService::~AuthService()
+{
+    stop();
+}
+
+void AuthService::start(const QString &databasePath, int threads, int maxQueue)
+{
+    stop();
+    m_databasePath = databasePath;
+    m_maxQueue = qMax(1, maxQueue);
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+void AuthService::stop()
+{
+    // 丢弃尚未开始的请求，等待正在执行的完成；它们的结果不再送出
+    m_pool.clear();
+    m_pool.waitForDone();
+    m_generation++;
+    m_pending = 0;
+}
+
+bool AuthService::login(ConnectionId connection, const QJsonObject &request)
+{
+    return submit(AuthResult::Operation::Login, connection, request);
+}
+
+bool AuthService::registerUser(ConnectionId connection, const QJsonObject &request)
+{
+    return submit(AuthResult::Operation::Register, connection, request);
+}
+
+bool AuthService::submit(AuthResult::Operation operation, ConnectionId connection, const QJsonObject &request)
+{
+    if (m_pending >= m_maxQueue) {
+        m_stats.rejected++;
+        return false;
+    }
+    m_pending++;
+    m_stats.queueHighWater = qMax(m_stats.queueHighWater, m_pending);
+
+    QElapsedTimer timer;
+    timer.start();
+    const QString databasePath = m_databasePath;
+    const quint64 generation = m_generation;
+
+    m_pool.start([this, operation, connection, request, timer, databasePath, generation]() {
+        AuthResult result;
+        result.connection = connection;
+        result.operation = operation;
+        result.request = request;
+
+        QSqlDatabase database = threadDatabase(databasePath);
+        if (database.isOpen()) {
+            if (operation == AuthResult::Operation::Login) {
+                runLogin(database, &result);
+            } else {
+                runRegister(database, &result);
+            }
+        }
+
+        // 完成通知回到服务器所在线程
+        QMetaObject::invokeMethod(this, [this, result, timer, generation]() mutable {
+            if (generation != m_generation) return;
+            m_pending--;
+            result.latencyUs = timer.nsecsElapsed() / 1000;
+            m_stats.completed++;
+            m_stats.totalLatencyUs += result.latencyUs;
+            m_stats.maxLatencyUs = qMax(m_stats.maxLatencyUs, result.latencyUs);
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+AuthStats AuthService::takeStats()
+{
+    AuthStats stats = m_stats;
+    m_stats = AuthStats();
+    m_stats.queueHighWater = m_pending;
+    return stats;
+}
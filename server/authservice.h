@@ -0,0 +1,72 @@
+#ifndef AUTHSERVICE_H
+#define AUTHSERVICE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QThreadPool>
+#include "controlplane.h"
+#include "userdatabase.h"
+
+// 一次认证请求的结果，在调用者线程上通过 AuthService::finished 送回
+struct AuthResult {
+    enum class Operation {
+        Login,
+        Register
+    };
+
+    ConnectionId connection = 0;
+    Operation operation = Operation::Login;
+    bool ok = false;
+    UserCredentials user;   // 成功时为数据库中的用户记录
+    QJsonObject request;    // 原始请求，由服务器继续处理 (登录时的UDP端点、能力协商等)
+    qint64 latencyUs = 0;   // 从提交到完成，包括排队时间
+};
+
+// 认证统计，由 takeStats() 读取后清零
+struct AuthStats {
+    quint64 completed = 0;
+    quint64 rejected = 0;   // 队列已满被拒绝的请求
+    qint64 totalLatencyUs = 0;
+    qint64 maxLatencyUs = 0;
+    int queueHighWater = 0;
+};
+
+/**
+ * @brief 异步认证服务
+ *
+ * 登录和注册的数据库读写 (查询用户、更新最后登录时间、插入新用户) 在线程池中执行，
+ * 每个线程使用自己的SQLite连接，事件循环和语音转发不会被磁盘写入阻塞。
+ * 排队 (含正在执行) 的请求数超过上限时直接拒绝，由服务器回复客户端稍后重试。
+ */
+class AuthService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AuthService(QObject *parent = nullptr);
+    ~AuthService();
+
+    void start(const QString &databasePath, int threads, int maxQueue);
+    void stop();
+
+    // 返回false表示队列已满，请求未提交
+    bool login(ConnectionId connection, const QJsonObject &request);
+    bool registerUser(ConnectionId connection, const QJsonObject &request);
+
+    int pending() const { return m_pending; }
+    AuthStats takeStats();
+
+signals:
+    void finished(const AuthResult &result);
+
+private:
+    bool submit(AuthResult::Operation operation, ConnectionId connection, const QJsonObject &request);
+
+    QThreadPool m_pool;
+    QString m_databasePath;
+    int m_maxQueue = 0;
+    int m_pending = 0;
+    quint64 m_generation = 0; // stop() 后丢弃旧请求的完成通知
+    AuthStats m_stats;
+};
+
+#endif // AUTHSERVICE_H
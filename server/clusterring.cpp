@@ -0,0 +1,81 @@
+#include "clusterring.h"
+#include <QStringList>
+
+QVector<ClusterNode> ClusterRing::parseNodes(const QString &spec, QString *error)
+{
+    QVector<ClusterNode> nodes;
+    const QStringList entries = spec.split(',', Qt::SkipEmptyParts);
+    for (const QString &entry : entries) {
+        int eq = entry.indexOf('=');
+        int colon = entry.lastIndexOf(':');
+        if (eq <= 0 || colon <= eq + 1) {
+            *error = QString("Invalid cluster node '%1', expected id=host:port").arg(entry);
+            return {};
+        }
+
+        ClusterNode node;
+        node.id = entry.left(eq).trimmed();
+        node.host = entry.mid(eq + 1, colon - eq - 1).trimmed();
+        bool ok = false;
+        node.controlPort = entry.mid(colon + 1).toUShort(&ok);
+        if (!ok || node.controlPort == 0) {
+            *error = QString("Invalid port in cluster node '%1'").arg(entry);
+            return {};
+        }
+
+        for (const ClusterNode &existing : std::as_const(nodes)) {
+            if (existing.id == node.id) {
+                *error = QString("Duplicate cluster node id '%1'").arg(node.id);
+                return {};
+            }
+        }
+        nodes.append(node);
+    }
+    return nodes;
+}
+
+void ClusterRing::setNodes(const QVector<ClusterNode> &nodes)
+{
+    m_nodes = nodes;
+    m_ring.clear();
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        for (int v = 0; v < VIRTUAL_NODES; ++v) {
+            m_ring.insert(hash(m_nodes.at(i).id.toUtf8() + '#' + QByteArray::number(v)), i);
+        }
+    }
+}
+
+const ClusterNode *ClusterRing::node(const QString &id) const
+{
+    for (const ClusterNode &node : m_nodes) {
+        if (node.id == id) return &node;
+    }
+    return nullptr;
+}
+
+const ClusterNode *ClusterRing::ownerOf(const QString &channel) const
+{
+    if (m_ring.isEmpty()) return nullptr;
+
+    auto it = m_ring.lowerBound(hash(channel.toUtf8()));
+    if (it == m_ring.constEnd()) {
+        it = m_ring.constBegin(); // 环绕到起点
+    }
+    return &m_nodes.at(it.value());
+}
+
+quint64 ClusterRing::hash(const QByteArray &key)
+{
+    // FNV-1a 64位，再用MurmurHash3的fmix64打散，使相似的键 (id#0, id#1...) 在环上均匀分布
+    quint64 h = 14695981039346656037ULL;
+    for (char c : key) {
+        h ^= quint8(c);
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
@@ -0,0 +1,44 @@
+#ifndef CLUSTERRING_H
+#define CLUSTERRING_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+// 集群中的一个服务器节点
+struct ClusterNode {
+    QString id;
+    QString host;             // 客户端用于连接该节点的地址
+    quint16 controlPort = 0;
+};
+
+/**
+ * @brief 频道到节点的一致性哈希环
+ *
+ * 每个节点在环上放置多个虚拟节点，频道名哈希后顺时针找到的第一个虚拟节点即为所属节点。
+ * 增减节点时只有相邻区间的频道会迁移。哈希函数与进程无关 (不使用随机种子的qHash)，
+ * 因此使用相同节点列表的所有进程对频道归属的判断一致。
+ */
+class ClusterRing
+{
+public:
+    static constexpr int VIRTUAL_NODES = 64;
+
+    // 解析 "id=host:port,id=host:port,..." 格式的节点列表，出错时返回空列表并设置 error
+    static QVector<ClusterNode> parseNodes(const QString &spec, QString *error);
+
+    void setNodes(const QVector<ClusterNode> &nodes);
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+    const QVector<ClusterNode> &nodes() const { return m_nodes; }
+
+    const ClusterNode *node(const QString &id) const;
+    const ClusterNode *ownerOf(const QString &channel) const;
+
+private:
+    static quint64 hash(const QByteArray &key);
+
+    QVector<ClusterNode> m_nodes;
+    QMap<quint64, int> m_ring; // 虚拟节点位置 -> m_nodes 下标
+};
+
+#endif // CLUSTERRING_H
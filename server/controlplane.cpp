@@ -0,0 +1,522 @@
+#include "controlplane.h"
+#include "../src/controlcodec.h"
+#include "../src/crypto.h"
+#include "../src/frameparser.h"
+#include <QHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QJsonDocument>
+#include <QDebug>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <unistd.h>
+#endif
+
+// 接受连接后只把套接字描述符交给ControlPlane，套接字在所属工作线程内创建
+class ControlListener : public QTcpServer
+{
+public:
+    ControlListener(std::function<void(qintptr)> dispatch, QObject *parent)
+        : QTcpServer(parent)
+        , m_dispatch(std::move(dispatch))
+    {
+    }
+
+protected:
+    void incomingConnection(qintptr descriptor) override
+    {
+        m_dispatch(descriptor);
+    }
+
+private:
+    std::function<void(qintptr)> m_dispatch;
+};
+
+// 单个工作线程: 拥有分配给它的控制连接，完成 读取 -> 分帧 -> 解密/解码 以及 编码/加密 -> 写出
+class ControlWorker : public QObject
+{
+public:
+    using Flush = ControlPlane::Flush;
+
+    explicit ControlWorker(ControlPlane *plane)
+        : m_plane(plane)
+    {
+    }
+
+    ~ControlWorker()
+    {
+        closeAll();
+    }
+
+    void addConnection(ConnectionId id, qintptr descriptor)
+    {
+        QTcpSocket *socket = new QTcpSocket(this);
+        if (!socket->setSocketDescriptor(descriptor)) {
+            qWarning() << "Failed to adopt control connection:" << socket->errorString();
+            delete socket;
+            // 套接字没有接管描述符，由这里关闭
+#ifdef Q_OS_WIN
+            ::closesocket(SOCKET(descriptor));
+#else
+            ::close(int(descriptor));
+#endif
+            return;
+        }
+
+        // 消息在本轮事件循环结束时已合并为一次写入，不需要 Nagle 算法再等待
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        Connection &connection = m_connections[id];
+        connection.socket = socket;
+        connect(socket, &QTcpSocket::readyRead, this, [this, id]() { onReadyRead(id); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, id]() { onDisconnected(id); });
+
+        ControlPlane *plane = m_plane;
+        QHostAddress peerAddress = socket->peerAddress();
+        QMetaObject::invokeMethod(plane, [plane, id, peerAddress]() {
+            emit plane->connectionOpened(id, peerAddress);
+        });
+    }
+
+    void send(ConnectionId id, const QJsonObject &message, bool encrypted, Flush flush)
+    {
+        auto it = m_connections.find(id);
+        if (it == m_connections.end() || !it->socket->isOpen()) return;
+
+        Connection &connection = *it;
+        const QByteArray body = encode(message, connection.binary);
+        if (!encrypted || !connection.cipher) {
+            queueFrame(id, connection, FrameParser::frame(plainPayload(body, connection.binary),
+                                                          connection.parser.mode()), flush);
+            return;
+        }
+
+        QByteArray ciphertext = connection.cipher->encryptCBC(body);
+        if (!ciphertext.isEmpty()) {
+            queueFrame(id, connection, FrameParser::frame(encryptedPayload(ciphertext, connection.binary),
+                                                          connection.parser.mode()), flush);
+        }
+    }
+
+    void broadcast(const QVector<ConnectionId> &ids, const QJsonObject &message)
+    {
+        // 消息体按编码 (JSON / 二进制) 各只序列化一次
+        QByteArray bodies[2];
+        auto body = [&](bool binary) -> const QByteArray & {
+            QByteArray &data = bodies[binary];
+            if (data.isNull()) {
+                data = encode(message, binary);
+            }
+            return data;
+        };
+
+        // 有会话密钥的连接按编码分批加密；其余连接共享同一个已分帧的明文 (隐式共享，不复制)
+        struct Batch {
+            QVector<ConnectionId> ids;
+            QVector<Connection*> connections;
+            QVector<AesContext*> ciphers;
+        };
+        Batch batches[2];
+        QByteArray plainFrames[3]; // JSON换行分隔、JSON长度前缀、二进制
+
+        for (ConnectionId id : ids) {
+            auto it = m_connections.find(id);
+            if (it == m_connections.end() || !it->socket->isOpen()) continue;
+
+            Connection &connection = *it;
+            if (connection.cipher) {
+                Batch &batch = batches[connection.binary];
+                batch.ids.append(id);
+                batch.connections.append(&connection);
+                batch.ciphers.append(connection.cipher.get());
+                continue;
+            }
+
+            const FrameParser::Mode mode = connection.parser.mode();
+            QByteArray &frame = plainFrames[connection.binary ? 2 : (mode == FrameParser::Mode::Newline ? 0 : 1)];
+            if (frame.isNull()) {
+                frame = FrameParser::frame(plainPayload(body(connection.binary), connection.binary), mode);
+            }
+            queueFrame(id, connection, frame, Flush::Deferred);
+        }
+
+        for (int binary = 0; binary < 2; ++binary) {
+            const Batch &batch = batches[binary];
+            if (batch.connections.isEmpty()) continue;
+
+            const QVector<QByteArray> encrypted = CryptoUtils::encryptAES_CBC(body(binary), batch.ciphers);
+            for (int i = 0; i < batch.connections.size(); ++i) {
+                if (encrypted.at(i).isEmpty()) continue;
+                Connection *connection = batch.connections.at(i);
+                queueFrame(batch.ids.at(i), *connection,
+                           FrameParser::frame(encryptedPayload(encrypted.at(i), binary), connection->parser.mode()),
+                           Flush::Deferred);
+            }
+        }
+    }
+
+    void completeLogin(ConnectionId id, QJsonObject response, const QByteArray &sessionKey, bool binaryRequested)
+    {
+        auto it = m_connections.find(id);
+        if (it == m_connections.end()) return;
+
+        // 本响应仍按当前编码以明文发送，之后的消息才使用新的会话密钥和编码
+        bool binary = binaryRequested && it->parser.mode() == FrameParser::Mode::LengthPrefixed;
+        if (binary) {
+            response["encoding"] = "binary";
+        }
+        send(id, response, false, Flush::Immediate);
+        it->cipher = std::make_shared<AesContext>(sessionKey);
+        it->binary = binary;
+    }
+
+    void disconnectClient(ConnectionId id)
+    {
+        auto it = m_connections.find(id);
+        if (it != m_connections.end()) {
+            writeOutput(*it);
+            it->socket->disconnectFromHost();
+        }
+    }
+
+    ControlIoStats stats() const { return m_stats; }
+
+    // 停止时关闭所有连接，不再通知ControlPlane
+    void closeAll()
+    {
+        for (const Connection &connection : std::as_const(m_connections)) {
+            connection.socket->disconnect(this);
+            connection.socket->abort();
+            delete connection.socket;
+        }
+        m_connections.clear();
+        m_dirty.clear();
+    }
+
+private:
+    struct Connection {
+        QTcpSocket *socket = nullptr;
+        FrameParser parser;    // 回复使用与请求相同的分帧方式
+        std::shared_ptr<AesContext> cipher; // 会话密钥的AES上下文，登录后设置
+        bool binary = false;   // 登录时协商的二进制控制消息编码 (ControlCodec)
+        QByteArray output;     // 本轮事件循环中排队、尚未交给套接字的帧
+    };
+
+    static QByteArray encode(const QJsonObject &message, bool binary)
+    {
+        return binary ? ControlCodec::encode(message) : QJsonDocument(message).toJson(QJsonDocument::Compact);
+    }
+
+    // 二进制编码: [标志字节][消息体]；JSON: 消息体本身
+    static QByteArray plainPayload(const QByteArray &body, bool binary)
+    {
+        if (!binary) return body;
+        QByteArray payload;
+        payload.reserve(body.size() + 1);
+        payload.append(char(0));
+        payload.append(body);
+        return payload;
+    }
+
+    // 二进制编码直接携带密文；JSON连接使用Base64编码加密数据以安全传输
+    static QByteArray encryptedPayload(const QByteArray &ciphertext, bool binary)
+    {
+        if (!binary) return ciphertext.toBase64();
+        QByteArray payload;
+        payload.reserve(ciphertext.size() + 1);
+        payload.append(char(ControlCodec::FLAG_ENCRYPTED));
+        payload.append(ciphertext);
+        return payload;
+    }
+
+    // 帧先追加到连接的输出缓冲，本轮事件循环结束时每个连接只写一次
+    void queueFrame(ConnectionId id, Connection &connection, const QByteArray &frame, Flush flush)
+    {
+        if (connection.output.isEmpty()) {
+            m_dirty.append(id);
+        }
+        connection.output.append(frame);
+        m_stats.messagesSent++;
+
+        if (flush == Flush::Immediate) {
+            writeOutput(connection);
+            return;
+        }
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            QMetaObject::invokeMethod(this, [this]() { flushPending(); }, Qt::QueuedConnection);
+        }
+    }
+
+    void flushPending()
+    {
+        m_flushScheduled = false;
+        const QVector<ConnectionId> dirty = std::exchange(m_dirty, QVector<ConnectionId>());
+        for (ConnectionId id : dirty) {
+            auto it = m_connections.find(id);
+            if (it != m_connections.end()) {
+                writeOutput(*it);
+            }
+        }
+    }
+
+    // 整个输出缓冲作为一块交给套接字，flush 时一次系统调用写出 (内核缓冲区已满时除外)
+    // 统计按实际写出的缓冲计数，而不是 bytesWritten 信号 (一次信号可能合并多次写入)
+    void writeOutput(Connection &connection)
+    {
+        if (connection.output.isEmpty()) return;
+        const QByteArray output = std::exchange(connection.output, QByteArray());
+        if (connection.socket->write(output) < 0) return;
+        m_stats.writeCalls++;
+        m_stats.bytesSent += quint64(output.size());
+        connection.socket->flush();
+    }
+
+    void onReadyRead(ConnectionId id)
+    {
+        auto it = m_connections.find(id);
+        if (it == m_connections.end()) return;
+        it->parser.append(it->socket->readAll());
+
+        // 一次读取可能包含多条消息 (流水线请求)，也可能只有半条，不完整的部分留待下次读取
+        // 单线程模式下消息处理可能直接回调到本对象，每次重新查找连接
+        QByteArrayView frame;
+        for (;;) {
+            it = m_connections.find(id);
+            if (it == m_connections.end() || !it->parser.next(&frame)) break;
+
+            QJsonObject message;
+            if (!decode(*it, frame, &message)) continue;
+            ControlPlane *plane = m_plane;
+            QMetaObject::invokeMethod(plane, [plane, id, message]() {
+                emit plane->messageReceived(id, message);
+            });
+        }
+
+        it = m_connections.find(id);
+        if (it != m_connections.end() && it->parser.hasError()) {
+            qWarning() << "Control frame too large from" << it->socket->peerAddress().toString() << "- disconnecting";
+            it->socket->disconnectFromHost();
+        }
+    }
+
+    void onDisconnected(ConnectionId id)
+    {
+        auto it = m_connections.find(id);
+        if (it == m_connections.end()) return;
+        it->socket->deleteLater();
+        m_connections.erase(it);
+
+        ControlPlane *plane = m_plane;
+        QMetaObject::invokeMethod(plane, [plane, id]() {
+            emit plane->connectionClosed(id);
+        });
+    }
+
+    static bool decode(const Connection &connection, QByteArrayView frame, QJsonObject *message)
+    {
+        const QByteArray data = QByteArray::fromRawData(frame.data(), frame.size());
+
+        if (connection.binary) {
+            // 二进制编码: 1字节标志 + 消息体 (加密时为AES-CBC密文，无Base64)
+            if (data.isEmpty()) return false;
+            QByteArray body = QByteArray::fromRawData(data.constData() + 1, data.size() - 1);
+            if (quint8(data.at(0)) & ControlCodec::FLAG_ENCRYPTED) {
+                body = connection.cipher ? connection.cipher->decryptCBC(body) : QByteArray();
+                if (body.isEmpty()) {
+                    qWarning() << "Failed to decrypt message from" << connection.socket->peerAddress().toString();
+                    return false;
+                }
+            }
+            if (!ControlCodec::decode(body, message)) {
+                qWarning() << "Malformed binary control message from" << connection.socket->peerAddress().toString();
+                return false;
+            }
+            return true;
+        }
+
+        // 如果客户端已认证，解密消息
+        QByteArray decryptedData = data;
+        if (connection.cipher) {
+            // 从Base64解码
+            QByteArray decoded = QByteArray::fromBase64(data);
+            if (!decoded.isEmpty()) {
+                decryptedData = connection.cipher->decryptCBC(decoded);
+                if (decryptedData.isEmpty()) {
+                    qWarning() << "Failed to decrypt message from" << connection.socket->peerAddress().toString();
+                    return false;
+                }
+            }
+            // 不是Base64时可能是明文消息
+        }
+
+        QJsonDocument doc = QJsonDocument::fromJson(decryptedData);
+        if (!doc.isObject()) return false;
+        *message = doc.object();
+        return true;
+    }
+
+    ControlPlane *m_plane;
+    QHash<ConnectionId, Connection> m_connections;
+    QVector<ConnectionId> m_dirty; // 输出缓冲非空的连接
+    bool m_flushScheduled = false;
+    ControlIoStats m_stats;
+};
+
+ControlPlane::ControlPlane(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ControlPlane::~ControlPlane()
+{
+    close();
+}
+
+bool ControlPlane::listen(quint16 port, int threads)
+{
+    close();
+    m_error.clear();
+
+    // 线程数为0: 在当前线程上处理所有连接
+    if (threads <= 0) {
+        m_workers.append(new ControlWorker(this));
+    }
+    for (int i = 0; i < threads; ++i) {
+        QThread *thread = new QThread;
+        thread->setObjectName(QString("control-%1").arg(i));
+        ControlWorker *worker = new ControlWorker(this);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+        m_workers.append(worker);
+        m_threads.append(thread);
+    }
+
+    m_listener = new ControlListener([this](qintptr descriptor) { dispatch(descriptor); }, this);
+    if (!m_listener->listen(QHostAddress::Any, port)) {
+        m_error = m_listener->errorString();
+        close();
+        return false;
+    }
+
+    if (threads > 0) {
+        qInfo() << "Control plane started with" << threads << "threads";
+    }
+    return true;
+}
+
+void ControlPlane::close()
+{
+    delete m_listener;
+    m_listener = nullptr;
+
+    if (m_threads.isEmpty()) {
+        // 单线程模式: 工作对象属于当前线程
+        qDeleteAll(m_workers);
+        m_workers.clear();
+        return;
+    }
+
+    for (int i = 0; i < m_threads.size(); ++i) {
+        ControlWorker *worker = m_workers.at(i);
+        QMetaObject::invokeMethod(worker, [worker]() { worker->closeAll(); }, Qt::BlockingQueuedConnection);
+        m_threads.at(i)->quit();
+        m_threads.at(i)->wait();
+        delete m_threads.at(i);
+    }
+    m_threads.clear();
+    m_workers.clear();
+}
+
+void ControlPlane::dispatch(qintptr descriptor)
+{
+    // 按连接ID分配工作线程，同一连接的所有操作都在该线程上执行
+    ConnectionId id = m_nextId++;
+    ControlWorker *target = worker(id);
+    QMetaObject::invokeMethod(target, [target, id, descriptor]() {
+        target->addConnection(id, descriptor);
+    });
+}
+
+ControlWorker *ControlPlane::worker(ConnectionId id) const
+{
+    if (m_workers.isEmpty() || id == 0) return nullptr;
+    return m_workers.at(int(id % quint64(m_workers.size())));
+}
+
+void ControlPlane::send(ConnectionId id, const QJsonObject &message, Flush flush)
+{
+    ControlWorker *target = worker(id);
+    if (!target) return;
+    QMetaObject::invokeMethod(target, [target, id, message, flush]() { target->send(id, message, false, flush); });
+}
+
+void ControlPlane::sendEncrypted(ConnectionId id, const QJsonObject &message, Flush flush)
+{
+    ControlWorker *target = worker(id);
+    if (!target) return;
+    QMetaObject::invokeMethod(target, [target, id, message, flush]() { target->send(id, message, true, flush); });
+}
+
+void ControlPlane::broadcast(const QVector<ConnectionId> &ids, const QJsonObject &message)
+{
+    if (m_workers.isEmpty()) return;
+
+    // 每个工作线程只收到一次广播，由它为自己的连接序列化和批量加密
+    QVector<QVector<ConnectionId>> groups(m_workers.size());
+    for (ConnectionId id : ids) {
+        if (id != 0) {
+            groups[int(id % quint64(m_workers.size()))].append(id);
+        }
+    }
+    for (int i = 0; i < groups.size(); ++i) {
+        if (groups.at(i).isEmpty()) continue;
+        ControlWorker *target = m_workers.at(i);
+        QVector<ConnectionId> group = groups.at(i);
+        QMetaObject::invokeMethod(target, [target, group, message]() { target->broadcast(group, message); });
+    }
+}
+
+void ControlPlane::completeLogin(ConnectionId id, const QJsonObject &response, const QByteArray &sessionKey,
+                                 bool binaryRequested)
+{
+    ControlWorker *target = worker(id);
+    if (!target) return;
+    QMetaObject::invokeMethod(target, [target, id, response, sessionKey, binaryRequested]() {
+        target->completeLogin(id, response, sessionKey, binaryRequested);
+    });
+}
+
+void ControlPlane::disconnectClient(ConnectionId id)
+{
+    ControlWorker *target = worker(id);
+    if (!target) return;
+    QMetaObject::invokeMethod(target, [target, id]() { target->disconnectClient(id); });
+}
+
+ControlIoStats ControlPlane::stats() const
+{
+    ControlIoStats total;
+    for (ControlWorker *worker : m_workers) {
+        ControlIoStats stats;
+        if (m_threads.isEmpty()) {
+            stats = worker->stats();
+        } else {
+            // 统计数据只在工作线程内修改，在该线程内读取
+            QMetaObject::invokeMethod(worker, [worker, &stats]() {
+                stats = worker->stats();
+            }, Qt::BlockingQueuedConnection);
+        }
+        total.messagesSent += stats.messagesSent;
+        total.writeCalls += stats.writeCalls;
+        total.bytesSent += stats.bytesSent;
+    }
+    return total;
+}
@@ -0,0 +1,83 @@
+#ifndef CONTROLPLANE_H
+#define CONTROLPLANE_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QVector>
+
+class QThread;
+class QTcpServer;
+class ControlWorker;
+
+// 控制连接的标识，由ControlPlane依次分配，不会复用 (0 表示无连接)
+using ConnectionId = quint64;
+
+// 控制连接输出统计 (用于计算每条消息的写入次数)
+struct ControlIoStats {
+    quint64 messagesSent = 0;
+    quint64 writeCalls = 0; // 输出缓冲交给套接字写出的次数 (通常各对应一次 write 系统调用，内核缓冲区已满时更多)
+    quint64 bytesSent = 0;
+};
+
+/**
+ * @brief 控制连接平面
+ *
+ * 接受的控制连接按连接ID分配到N个工作线程。每个连接的套接字读写、分帧、
+ * AES-CBC加解密以及JSON/二进制编解码都在所属线程内完成，慢客户端只占用自己所在的线程。
+ * 服务器状态 (频道、会话、数据库) 仍只在调用者线程上访问: 通过信号收到解码后的消息，
+ * 再按连接ID发送回复，因此状态本身不需要加锁。
+ * 线程数为0时，所有连接都在调用者线程上处理 (原有行为)。
+ *
+ * 输出按连接合并: 同一轮事件循环中发给同一连接的消息在该轮结束时一次写出，
+ * 所有连接都设置 TCP_NODELAY，合并由这里完成而不是依赖 Nagle 算法。
+ */
+class ControlPlane : public QObject
+{
+    Q_OBJECT
+public:
+    // Deferred: 与同一连接本轮的其他消息合并写出；Immediate: 连同之前排队的消息立即写出
+    enum class Flush {
+        Deferred,
+        Immediate
+    };
+
+    explicit ControlPlane(QObject *parent = nullptr);
+    ~ControlPlane();
+
+    bool listen(quint16 port, int threads);
+    void close();
+    QString errorString() const { return m_error; }
+    int threadCount() const { return m_threads.size(); }
+
+    // 以下只在调用者线程调用；同一连接上的操作按调用顺序执行，连接已断开时忽略
+    void send(ConnectionId id, const QJsonObject &message, Flush flush = Flush::Deferred);
+    void sendEncrypted(ConnectionId id, const QJsonObject &message,
+                       Flush flush = Flush::Deferred); // 没有会话密钥时发送明文
+    void broadcast(const QVector<ConnectionId> &ids, const QJsonObject &message); // 有会话密钥的连接加密
+
+    // 发送登录响应 (立即写出)，随后的消息使用该会话密钥加解密
+    // binaryRequested 且连接使用长度前缀分帧时，响应中加入 "encoding": "binary" 并切换为二进制编码
+    void completeLogin(ConnectionId id, const QJsonObject &response, const QByteArray &sessionKey,
+                       bool binaryRequested);
+    void disconnectClient(ConnectionId id); // 先写出排队的消息
+
+    ControlIoStats stats() const;
+
+signals:
+    void connectionOpened(ConnectionId id, const QHostAddress &peerAddress);
+    void messageReceived(ConnectionId id, const QJsonObject &message);
+    void connectionClosed(ConnectionId id);
+
+private:
+    void dispatch(qintptr descriptor);
+    ControlWorker *worker(ConnectionId id) const;
+
+    QTcpServer *m_listener = nullptr;
+    QVector<ControlWorker*> m_workers;
+    QVector<QThread*> m_threads;
+    ConnectionId m_nextId = 1;
+    QString m_error;
+};
+
+#endif // CONTROLPLANE_H
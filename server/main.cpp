@@ -16,6 +16,16 @@ int main(int argc, char *argv[])
         "\n可用选项:\n"
         "  -c, --control-port <port>  指定客户端控制连接端口 (默认: 8888)\n"
         "  -p, --voice-port <port>    指定UDP语音端口 (默认: 8889)\n"
+        "  --voice-io <backend>       语音端口I/O后端: qt、batched 或 uring (默认: qt)\n"
+        "  --voice-threads <n>        语音转发线程数，0 表示在主线程转发 (默认: 0，仅Linux)\n"
+        "  --control-threads <n>      控制连接工作线程数，0 表示在主线程处理 (默认: 0)\n"
+        "  --auth-threads <n>         登录/注册的数据库线程数 (默认: 2)\n"
+        "  --auth-queue <n>           排队认证请求上限，超出时拒绝 (默认: 256)\n"
+        "  --db <path>                用户数据库文件 (默认: voicephone.db)\n"
+        "  --cluster-nodes <list>     集群节点列表: id=host:port,id=host:port,...\n"
+        "  --node-id <id>             本节点在集群节点列表中的ID\n"
+        "  --presence-window <ms>     合并频道成员变化的窗口 (默认: 100)\n"
+        "  --resume-grace <s>         断线后保留会话等待恢复的秒数，0 表示禁用 (默认: 30)\n"
         "  -h, --help                 显示本帮助信息\n"
         "  --version                  显示版本信息\n"
         "\n如果未指定参数，服务器将使用默认端口启动。\n"
@@ -30,12 +40,134 @@ int main(int argc, char *argv[])
     QCommandLineOption voicePortOption(QStringList() << "p" << "voice-port",
         "Voice port for UDP audio (default: 8889)", "port", "8889");
     parser.addOption(voicePortOption);
+
+    QCommandLineOption voiceIoOption("voice-io",
+        "Voice socket I/O backend: qt, batched (recvmmsg/sendmmsg, Linux only) "
+        "or uring (io_uring, Linux only, requires a VOICEPHONE_IO_URING build) (default: qt)",
+        "backend", "qt");
+    parser.addOption(voiceIoOption);
+
+    QCommandLineOption voiceThreadsOption("voice-threads",
+        "Number of voice forwarding threads sharing the voice port via SO_REUSEPORT, "
+        "0 forwards on the control thread (default: 0)", "n", "0");
+    parser.addOption(voiceThreadsOption);
+
+    QCommandLineOption controlThreadsOption("control-threads",
+        "Number of worker threads for control connections (framing, encryption, encoding), "
+        "0 handles them on the main thread (default: 0)", "n", "0");
+    parser.addOption(controlThreadsOption);
+
+    QCommandLineOption authThreadsOption("auth-threads",
+        "Number of threads running login/registration database work (default: 2)", "n", "2");
+    parser.addOption(authThreadsOption);
+
+    QCommandLineOption authQueueOption("auth-queue",
+        "Maximum queued login/registration requests, further requests are rejected (default: 256)", "n", "256");
+    parser.addOption(authQueueOption);
+
+    QCommandLineOption dbOption("db",
+        "User database file, shared by all nodes of a cluster (default: voicephone.db)", "path", "voicephone.db");
+    parser.addOption(dbOption);
+
+    QCommandLineOption clusterNodesOption("cluster-nodes",
+        "Cluster nodes as id=host:port,... (host:port is the control address clients are redirected to)", "list");
+    parser.addOption(clusterNodesOption);
+
+    QCommandLineOption nodeIdOption("node-id", "ID of this node in --cluster-nodes", "id");
+    parser.addOption(nodeIdOption);
+
+    QCommandLineOption presenceWindowOption("presence-window",
+        "Milliseconds to coalesce channel join/leave events into one presence delta (default: 100)", "ms", "100");
+    parser.addOption(presenceWindowOption);
+
+    QCommandLineOption resumeGraceOption("resume-grace",
+        "Seconds a disconnected session stays resumable, 0 disables resumption (default: 30)", "seconds", "30");
+    parser.addOption(resumeGraceOption);
     parser.process(app);
 
     quint16 controlPort = parser.value(controlPortOption).toUShort();
     quint16 voicePort = parser.value(voicePortOption).toUShort();
 
+    bool backendOk = false;
+    VoiceIoBackend voiceIoBackend = VoiceTransport::parseBackend(parser.value(voiceIoOption), &backendOk);
+    if (!backendOk) {
+        qCritical() << "Unknown voice I/O backend:" << parser.value(voiceIoOption);
+        return 1;
+    }
+
+    bool threadsOk = false;
+    int voiceThreads = parser.value(voiceThreadsOption).toInt(&threadsOk);
+    if (!threadsOk || voiceThreads < 0) {
+        qCritical() << "Invalid voice thread count:" << parser.value(voiceThreadsOption);
+        return 1;
+    }
+
+    bool windowOk = false;
+    int presenceWindow = parser.value(presenceWindowOption).toInt(&windowOk);
+    if (!windowOk || presenceWindow < 0) {
+        qCritical() << "Invalid presence window:" << parser.value(presenceWindowOption);
+        return 1;
+    }
+
+    bool graceOk = false;
+    int resumeGrace = parser.value(resumeGraceOption).toInt(&graceOk);
+    if (!graceOk || resumeGrace < 0) {
+        qCritical() << "Invalid resume grace period:" << parser.value(resumeGraceOption);
+        return 1;
+    }
+
+    bool controlThreadsOk = false;
+    int controlThreads = parser.value(controlThreadsOption).toInt(&controlThreadsOk);
+    if (!controlThreadsOk || controlThreads < 0) {
+        qCritical() << "Invalid control thread count:" << parser.value(controlThreadsOption);
+        return 1;
+    }
+
+    bool authThreadsOk = false;
+    int authThreads = parser.value(authThreadsOption).toInt(&authThreadsOk);
+    if (!authThreadsOk || authThreads < 1) {
+        qCritical() << "Invalid auth thread count:" << parser.value(authThreadsOption);
+        return 1;
+    }
+
+    bool authQueueOk = false;
+    int authQueue = parser.value(authQueueOption).toInt(&authQueueOk);
+    if (!authQueueOk || authQueue < 1) {
+        qCritical() << "Invalid auth queue limit:" << parser.value(authQueueOption);
+        return 1;
+    }
+
+    QVector<ClusterNode> clusterNodes;
+    QString nodeId = parser.value(nodeIdOption);
+    if (parser.isSet(clusterNodesOption)) {
+        QString error;
+        clusterNodes = ClusterRing::parseNodes(parser.value(clusterNodesOption), &error);
+        if (clusterNodes.isEmpty()) {
+            qCritical() << (error.isEmpty() ? QString("Empty cluster node list") : error);
+            return 1;
+        }
+        bool found = false;
+        for (const ClusterNode &node : std::as_const(clusterNodes)) {
+            found = found || node.id == nodeId;
+        }
+        if (!found) {
+            qCritical() << "--node-id must name one of the --cluster-nodes entries";
+            return 1;
+        }
+    }
+
     VoiceServer server;
+    server.setVoiceIoBackend(voiceIoBackend);
+    server.setVoiceThreads(voiceThreads);
+    server.setControlThreads(controlThreads);
+    server.setAuthThreads(authThreads);
+    server.setAuthQueueLimit(authQueue);
+    server.setDatabasePath(parser.value(dbOption));
+    server.setPresenceWindow(presenceWindow);
+    server.setResumeGrace(resumeGrace);
+    if (!clusterNodes.isEmpty()) {
+        server.setCluster(nodeId, clusterNodes);
+    }
     if (!server.startServer(controlPort, voicePort)) {
         qCritical() << "Failed to start server!";
         return 1;
@@ -1,26 +1,57 @@
 #include "server.h"
+#include "authservice.h"
 #include "userdatabase.h"
+#include "voicemixer.h"
+#include "speakerselector.h"
 #include "../src/crypto.h"
-#include <QTcpSocket>
+#include "../src/voicepacket.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QTimer>
 #include <QDebug>
+#include <utility>
+
+// 语音I/O统计的输出间隔
+static constexpr int VOICE_STATS_INTERVAL_MS = 60000;
+
+// 每个频道保留的成员增量个数
+static constexpr int PRESENCE_HISTORY = 64;
+
+// 检查断线会话是否已过宽限期的间隔
+static constexpr int RESUME_CHECK_INTERVAL_MS = 1000;
+
+// 把一次加入/离开合并进增量: 同一用户先加入后离开 (或反之) 互相抵消
+static void applyPresence(QStringList *joined, QStringList *left, const QString &username, bool isJoin)
+{
+    if (isJoin) {
+        if (!left->removeOne(username)) joined->append(username);
+    } else {
+        if (!joined->removeOne(username)) left->append(username);
+    }
+}
 
 VoiceServer::VoiceServer(QObject *parent)
     : QObject(parent)
-    , m_controlServer(new QTcpServer(this))
-    , m_voiceSocket(new QUdpSocket(this))
+    , m_controlPlane(new ControlPlane(this))
+    , m_voicePlane(new VoicePlane(this))
+    , m_statsTimer(new QTimer(this))
+    , m_presenceTimer(new QTimer(this))
+    , m_resumeTimer(new QTimer(this))
     , m_userDatabase(new UserDatabase(this))
+    , m_authService(new AuthService(this))
     , m_voicePort(0)
 {
-    // 初始化数据库
-    if (!m_userDatabase->initialize("voicephone.db")) {
-        qCritical() << "Failed to initialize user database";
-    }
-    
-    connect(m_controlServer, &QTcpServer::newConnection, this, &VoiceServer::onNewConnection);
-    connect(m_voiceSocket, &QUdpSocket::readyRead, this, &VoiceServer::onVoiceDataReceived);
+    connect(m_controlPlane, &ControlPlane::connectionOpened, this, &VoiceServer::onConnectionOpened);
+    connect(m_controlPlane, &ControlPlane::messageReceived, this, &VoiceServer::handleControlMessage);
+    connect(m_controlPlane, &ControlPlane::connectionClosed, this, &VoiceServer::onConnectionClosed);
+    connect(m_statsTimer, &QTimer::timeout, this, &VoiceServer::reportVoiceIoStats);
+    connect(m_statsTimer, &QTimer::timeout, this, &VoiceServer::reportControlIoStats);
+    connect(m_statsTimer, &QTimer::timeout, this, &VoiceServer::reportAuthStats);
+    connect(m_authService, &AuthService::finished, this, &VoiceServer::onAuthFinished);
+    m_presenceTimer->setSingleShot(true);
+    connect(m_presenceTimer, &QTimer::timeout, this, &VoiceServer::flushPresence);
+    connect(m_resumeTimer, &QTimer::timeout, this, &VoiceServer::expireDetachedSessions);
 }
 
 VoiceServer::~VoiceServer()
@@ -28,207 +59,245 @@ VoiceServer::~VoiceServer()
     stopServer();
 }
 
+void VoiceServer::setCluster(const QString &nodeId, const QVector<ClusterNode> &nodes)
+{
+    m_nodeId = nodeId;
+    m_clusterRing.setNodes(nodes);
+}
+
 bool VoiceServer::startServer(quint16 controlPort, quint16 voicePort)
 {
-    if (!m_controlServer->listen(QHostAddress::Any, controlPort)) {
-        qWarning() << "Failed to start control server:" << m_controlServer->errorString();
+    // 初始化数据库
+    if (!m_userDatabase->initialize(m_databasePath)) {
+        qCritical() << "Failed to initialize user database";
+        return false;
+    }
+    m_authService->start(m_databasePath, m_authThreads, m_authQueueLimit);
+
+    if (!m_controlPlane->listen(controlPort, m_controlThreads)) {
+        qWarning() << "Failed to start control server:" << m_controlPlane->errorString();
         return false;
     }
 
-    if (!m_voiceSocket->bind(QHostAddress::Any, voicePort)) {
-        qWarning() << "Failed to bind voice socket:" << m_voiceSocket->errorString();
-        m_controlServer->close();
+    if (!m_voicePlane->start(voicePort, m_voiceThreads, m_voiceIoBackend)) {
+        qWarning() << "Failed to bind voice socket:" << m_voicePlane->errorString();
+        m_controlPlane->close();
         return false;
     }
 
     m_voicePort = voicePort;
-    qInfo() << "Server started - Control:" << controlPort << "Voice:" << voicePort;
+    m_reportedIoStats = VoiceIoStats();
+    m_reportedControlStats = ControlIoStats();
+    m_statsTimer->start(VOICE_STATS_INTERVAL_MS);
+    qInfo() << "Server started - Control:" << controlPort << "Voice:" << voicePort
+            << "Voice I/O:" << m_voicePlane->backendName()
+            << "Voice threads:" << m_voicePlane->threadCount()
+            << "Control threads:" << m_controlPlane->threadCount();
+    if (!m_clusterRing.isEmpty()) {
+        qInfo() << "Cluster node:" << m_nodeId << "of" << m_clusterRing.nodes().size() << "nodes";
+    }
     
     // 创建默认频道
-    m_channels["General"] = QSet<QTcpSocket*>();
-    m_channels["Gaming"] = QSet<QTcpSocket*>();
+    m_channels["General"] = QSet<ConnectionId>();
+    m_channels["Gaming"] = QSet<ConnectionId>();
     
     return true;
 }
 
 void VoiceServer::stopServer()
 {
-    m_controlServer->close();
-    m_voiceSocket->close();
-    
-    for (auto socket : m_clients.keys()) {
-        socket->disconnectFromHost();
+    m_controlPlane->close();
+    m_authService->stop();
+    m_statsTimer->stop();
+    m_presenceTimer->stop();
+    m_resumeTimer->stop();
+    if (m_voicePlane->isRunning()) {
+        reportVoiceIoStats();
+        m_voicePlane->stop();
     }
+    
     m_clients.clear();
+    m_sessionToConnection.clear();
+    m_resumeTickets.clear();
+    m_voiceEndpoints.clear();
+    m_voiceIds.clear();
     m_channels.clear();
+    m_channelRoutes.clear();
+    m_mixChannels.clear();
+    m_mixStreamIds.clear();
+    m_speakerSelectors.clear();
+    m_presence.clear();
+    m_dirtyPresence.clear();
 }
 
-void VoiceServer::onNewConnection()
+void VoiceServer::onConnectionOpened(ConnectionId connection, const QHostAddress &peerAddress)
 {
-    QTcpSocket *socket = m_controlServer->nextPendingConnection();
-    if (!socket) return;
-
-    qInfo() << "New client connected:" << socket->peerAddress().toString();
+    qInfo() << "New client connected:" << peerAddress.toString();
     
     ClientInfo info;
-    info.controlSocket = socket;
+    info.peerAddress = peerAddress;
     info.isConnected = true;
-    m_clients[socket] = info;
-
-    connect(socket, &QTcpSocket::disconnected, this, &VoiceServer::onClientDisconnected);
-    connect(socket, &QTcpSocket::readyRead, this, &VoiceServer::onControlDataReceived);
+    m_clients[connection] = info;
 }
 
-void VoiceServer::onClientDisconnected()
+void VoiceServer::onConnectionClosed(ConnectionId connection)
 {
-    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket || !m_clients.contains(socket)) return;
+    auto client = m_clients.find(connection);
+    if (client == m_clients.end()) return;
+    ClientInfo &info = client.value();
+
+    // 已登录的客户端在宽限期内保留会话、频道成员和语音转发，等待凭票据重新连接
+    if (info.isAuthenticated && !info.resumeTicket.isEmpty()) {
+        info.detached = true;
+        info.resumeDeadline = QDeadlineTimer(m_resumeGrace * 1000);
+        if (!m_resumeTimer->isActive()) {
+            m_resumeTimer->start(RESUME_CHECK_INTERVAL_MS);
+        }
+        qInfo() << "Client disconnected:" << info.username << "- session held for" << m_resumeGrace << "s";
+        return;
+    }
 
-    ClientInfo &info = m_clients[socket];
     qInfo() << "Client disconnected:" << info.username;
+    releaseClient(connection);
+}
+
+void VoiceServer::expireDetachedSessions()
+{
+    QVector<ConnectionId> expired;
+    bool detached = false;
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+        if (!it->detached) continue;
+        if (it->resumeDeadline.hasExpired()) {
+            expired.append(it.key());
+        } else {
+            detached = true;
+        }
+    }
+
+    for (ConnectionId connection : std::as_const(expired)) {
+        qInfo() << "Session expired:" << m_clients[connection].username;
+        releaseClient(connection);
+    }
+    if (!detached) {
+        m_resumeTimer->stop();
+    }
+}
+
+void VoiceServer::releaseClient(ConnectionId connection)
+{
+    auto client = m_clients.find(connection);
+    if (client == m_clients.end()) return;
+    ClientInfo &info = client.value();
+
+    if (!info.resumeTicket.isEmpty()) {
+        m_resumeTickets.remove(info.resumeTicket);
+    }
 
     // 移除会话
     if (!info.sessionId.isEmpty()) {
         m_userDatabase->removeSession(info.sessionId);
-        m_sessionToSocket.remove(info.sessionId);
+        m_sessionToConnection.remove(info.sessionId);
+    }
+
+    clearVoiceEndpoint(connection, info);
+    if (info.voiceId != 0) {
+        m_voiceIds.remove(info.voiceId);
     }
 
     // 从频道中移除
     if (!info.currentChannel.isEmpty()) {
-        m_channels[info.currentChannel].remove(socket);
+        m_channels[info.currentChannel].remove(connection);
+        scheduleVoiceRoutesUpdate(info.currentChannel);
         
         // 通知频道内其他用户
-        QJsonObject msg;
-        msg["type"] = "user_left";
-        msg["username"] = info.username;
-        msg["channel"] = info.currentChannel;
-        broadcastToChannel(info.currentChannel, 
-            QJsonDocument(msg).toJson(QJsonDocument::Compact));
+        recordPresence(info.currentChannel, connection, info.username, false);
     }
 
-    m_clients.remove(socket);
-    socket->deleteLater();
+    m_clients.remove(connection);
 }
 
-void VoiceServer::onControlDataReceived()
+void VoiceServer::reportVoiceIoStats()
 {
-    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket || !m_clients.contains(socket)) return;
+    if (!m_voicePlane->isRunning()) return;
+
+    VoiceIoStats stats = m_voicePlane->stats();
+    quint64 rxPackets = stats.packetsReceived - m_reportedIoStats.packetsReceived;
+    quint64 rxCalls = stats.receiveCalls - m_reportedIoStats.receiveCalls;
+    quint64 txPackets = stats.packetsSent - m_reportedIoStats.packetsSent;
+    quint64 txCalls = stats.sendCalls - m_reportedIoStats.sendCalls;
+    quint64 poolExhausted = stats.poolExhausted - m_reportedIoStats.poolExhausted;
+    m_reportedIoStats = stats;
 
-    QByteArray data = socket->readAll();
-    handleControlMessage(socket, data);
+    if (rxPackets == 0 && txPackets == 0) return;
+
+    qInfo().nospace() << "Voice I/O [" << m_voicePlane->backendName() << "] - "
+                      << "rx: " << rxPackets << " packets / " << rxCalls << " syscalls ("
+                      << (rxCalls ? double(rxPackets) / rxCalls : 0.0) << " per call), "
+                      << "tx: " << txPackets << " packets / " << txCalls << " syscalls ("
+                      << (txCalls ? double(txPackets) / txCalls : 0.0) << " per call), "
+                      << "buffers: " << stats.poolInUse << "/" << stats.poolCapacity << " in use, "
+                      << "peak " << stats.poolHighWater << ", " << poolExhausted << " exhausted";
 }
 
-void VoiceServer::onVoiceDataReceived()
+void VoiceServer::reportControlIoStats()
 {
-    while (m_voiceSocket->hasPendingDatagrams()) {
-        QByteArray datagram;
-        datagram.resize(int(m_voiceSocket->pendingDatagramSize()));
-        QHostAddress sender;
-        quint16 senderPort;
-        
-        m_voiceSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        
-        // 查找发送者并转发音频数据
-        for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
-            if (it->udpAddress == sender && it->udpPort == senderPort) {
-                if (!it->currentChannel.isEmpty() && it->isAuthenticated) {
-                    // 直接转发音频数据（客户端之间端到端加密）
-                    broadcastVoiceToChannel(it->currentChannel, datagram, it.key());
-                }
-                break;
-            }
-        }
-    }
+    ControlIoStats stats = m_controlPlane->stats();
+    quint64 messages = stats.messagesSent - m_reportedControlStats.messagesSent;
+    quint64 writes = stats.writeCalls - m_reportedControlStats.writeCalls;
+    quint64 bytes = stats.bytesSent - m_reportedControlStats.bytesSent;
+    m_reportedControlStats = stats;
+
+    if (messages == 0) return;
+
+    qInfo().nospace() << "Control I/O - " << messages << " messages / " << writes << " socket writes ("
+                      << double(writes) / messages << " per message), " << bytes << " bytes";
 }
 
-void VoiceServer::handleControlMessage(QTcpSocket *socket, const QByteArray &data)
+void VoiceServer::reportAuthStats()
 {
-    ClientInfo &info = m_clients[socket];
-    
-    // 如果客户端已认证，解密消息
-    QByteArray decryptedData = data;
-    if (info.isAuthenticated && !info.sessionId.isEmpty()) {
-        QByteArray sessionKey = m_userDatabase->getSessionKey(info.sessionId);
-        if (!sessionKey.isEmpty()) {
-            // 从Base64解码
-            QByteArray decoded = QByteArray::fromBase64(data);
-            if (!decoded.isEmpty()) {
-                decryptedData = CryptoUtils::decryptAES_CBC(decoded, sessionKey);
-                if (decryptedData.isEmpty()) {
-                    qWarning() << "Failed to decrypt message from" << info.username;
-                    return;
-                }
-            } else {
-                // 不是Base64，可能是明文消息
-                decryptedData = data;
-            }
-        }
-    }
-    
-    QJsonDocument doc = QJsonDocument::fromJson(decryptedData);
-    if (!doc.isObject()) return;
+    AuthStats stats = m_authService->takeStats();
+    if (stats.completed == 0 && stats.rejected == 0) return;
+
+    qInfo().nospace() << "Auth - " << stats.completed << " completed, latency avg "
+                      << (stats.completed ? double(stats.totalLatencyUs) / stats.completed / 1000.0 : 0.0)
+                      << " ms, max " << stats.maxLatencyUs / 1000.0 << " ms, "
+                      << stats.rejected << " rejected, queue peak " << stats.queueHighWater;
+}
+
+void VoiceServer::handleControlMessage(ConnectionId connection, const QJsonObject &obj)
+{
+    // 消息已由连接所在的工作线程解密和解码
+    auto client = m_clients.find(connection);
+    if (client == m_clients.end()) return;
+    ClientInfo &info = client.value();
 
-    QJsonObject obj = doc.object();
     QString type = obj["type"].toString();
 
-    // 处理注册请求（无需认证）
-    if (type == "register") {
-        QString username = obj["username"].toString();
-        QByteArray passwordHash = QByteArray::fromHex(obj["password_hash"].toString().toUtf8());
-        
-        if (m_userDatabase->registerUser(username, passwordHash)) {
-            QJsonObject response;
-            response["type"] = "register_success";
-            sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
-        } else {
-            QJsonObject response;
-            response["type"] = "error";
-            response["message"] = "Registration failed - user may already exist";
-            sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
+    // 注册和登录（无需认证）: 数据库读写交给认证线程池，完成后在 onAuthFinished 中继续
+    if (type == "register" || type == "login") {
+        if (info.authPending) {
+            sendError(connection, "Authentication already in progress");
+            return;
+        }
+        if (type == "register" && m_userDatabase->userExists(obj["username"].toString())) {
+            sendError(connection, "Registration failed - user may already exist");
+            return;
         }
+
+        bool queued = type == "login" ? m_authService->login(connection, obj)
+                                      : m_authService->registerUser(connection, obj);
+        if (!queued) {
+            qWarning() << "Authentication queue full, rejecting" << type << "from" << info.peerAddress.toString();
+            sendError(connection, "Server busy - please retry later");
+            return;
+        }
+        info.authPending = true;
         return;
     }
-    
-    // 处理登录请求（无需认证）
-    if (type == "login") {
-        QString username = obj["username"].toString();
-        QByteArray passwordHash = QByteArray::fromHex(obj["password_hash"].toString().toUtf8());
-        
-        if (m_userDatabase->authenticate(username, passwordHash)) {
-            // 生成会话令牌和加密密钥
-            QByteArray sessionToken = CryptoUtils::generateSessionToken();
-            QString sessionId = m_userDatabase->createSession(username, sessionToken);
-            
-            // 生成会话加密密钥
-            QByteArray sessionKey = CryptoUtils::generateAESKey();
-            m_userDatabase->setSessionKey(sessionId, sessionKey);
-            
-            // 更新客户端信息
-            info.username = username;
-            info.sessionId = sessionId;
-            info.udpAddress = QHostAddress(obj["udp_ip"].toString());
-            info.udpPort = obj["udp_port"].toInt();
-            info.isAuthenticated = true;
-            info.audioCounter = 0;
-            
-            m_sessionToSocket[sessionId] = socket;
-            
-            // 发送成功响应（包含会话令牌和加密密钥）
-            QJsonObject response;
-            response["type"] = "login_success";
-            response["voice_port"] = m_voicePort;
-            response["session_id"] = sessionId;
-            response["session_key"] = QString::fromUtf8(sessionKey.toHex());
-            sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
-            
-            qInfo() << "User logged in:" << username;
-        } else {
-            QJsonObject response;
-            response["type"] = "error";
-            response["message"] = "Authentication failed";
-            sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
-        }
+
+    // 凭上次登录得到的票据恢复会话（无需认证）
+    if (type == "resume") {
+        resumeSession(connection, obj);
         return;
     }
     
@@ -237,148 +306,354 @@ void VoiceServer::handleControlMessage(QTcpSocket *socket, const QByteArray &dat
         QJsonObject response;
         response["type"] = "error";
         response["message"] = "Authentication required";
-        sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
+        sendToClient(connection, response);
         return;
     }
     
-    if (type == "join_channel") {
+    if (type == "logout") {
+        // 主动退出: 作废票据，连接关闭时立即释放会话
+        m_resumeTickets.remove(info.resumeTicket);
+        info.resumeTicket.clear();
+    }
+    else if (type == "join_channel") {
         QString newChannel = obj["channel"].toString();
+
+        // 频道属于其他节点: 重定向客户端，由客户端重新连接并登录后再加入
+        if (const ClusterNode *owner = channelOwner(newChannel)) {
+            QJsonObject response;
+            response["type"] = "redirect";
+            response["channel"] = newChannel;
+            response["node"] = owner->id;
+            response["host"] = owner->host;
+            response["control_port"] = owner->controlPort;
+            sendEncryptedToClient(connection, response);
+            qInfo() << info.username << "redirected to node" << owner->id << "for channel:" << newChannel;
+            return;
+        }
         
         // 离开旧频道
         if (!info.currentChannel.isEmpty()) {
-            m_channels[info.currentChannel].remove(socket);
-            
-            QJsonObject leaveMsg;
-            leaveMsg["type"] = "user_left";
-            leaveMsg["username"] = info.username;
-            broadcastToChannel(info.currentChannel, 
-                QJsonDocument(leaveMsg).toJson(QJsonDocument::Compact));
+            m_channels[info.currentChannel].remove(connection);
+            scheduleVoiceRoutesUpdate(info.currentChannel);
+            recordPresence(info.currentChannel, connection, info.username, false);
         }
         
         // 加入新频道
         info.currentChannel = newChannel;
         if (!m_channels.contains(newChannel)) {
-            m_channels[newChannel] = QSet<QTcpSocket*>();
+            m_channels[newChannel] = QSet<ConnectionId>();
             // 为新频道生成加密密钥
             m_channelKeys[newChannel] = CryptoUtils::generateAESKey();
             qInfo() << "Generated encryption key for channel:" << newChannel;
         }
-        m_channels[newChannel].insert(socket);
-        
-        // 重置音频计数器
-        info.audioCounter = 0;
+        m_channels[newChannel].insert(connection);
+        scheduleVoiceRoutesUpdate(newChannel);
         
         // 通知成功加入，并发送频道加密密钥
         QJsonObject response;
         response["type"] = "join_success";
         response["channel"] = newChannel;
         response["channel_key"] = QString::fromUtf8(m_channelKeys[newChannel].toHex());
-        sendEncryptedToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
+        // 客户端收到后才启动音频，不等本轮的其他消息
+        sendEncryptedToClient(connection, response, ControlPlane::Flush::Immediate);
         
-        // 发送频道用户列表
-        sendUserList(socket, newChannel);
+        // 发送频道用户列表: 旧客户端立即收到快照；支持增量的客户端在合并窗口结束时
+        // 收到快照，或者在重新加入且携带的版本仍在历史中时只收到之后的增量
+        info.presenceVersion = 0;
+        if (info.presenceDeltas) {
+            quint64 known = quint64(obj["presence_version"].toInteger());
+            auto presence = m_presence.constFind(newChannel);
+            if (presence != m_presence.constEnd() && known <= presence->version) {
+                info.presenceVersion = known;
+            }
+        } else {
+            sendUserList(connection, newChannel);
+        }
         
         // 通知频道内其他用户
-        QJsonObject joinMsg;
-        joinMsg["type"] = "user_joined";
-        joinMsg["username"] = info.username;
-        broadcastToChannel(newChannel, 
-            QJsonDocument(joinMsg).toJson(QJsonDocument::Compact), socket);
+        recordPresence(newChannel, connection, info.username, true);
         
         qInfo() << info.username << "joined channel:" << newChannel;
     }
     else if (type == "leave_channel") {
         if (!info.currentChannel.isEmpty()) {
-            m_channels[info.currentChannel].remove(socket);
-            
-            QJsonObject msg;
-            msg["type"] = "user_left";
-            msg["username"] = info.username;
-            broadcastToChannel(info.currentChannel, 
-                QJsonDocument(msg).toJson(QJsonDocument::Compact));
+            m_channels[info.currentChannel].remove(connection);
+            scheduleVoiceRoutesUpdate(info.currentChannel);
+            recordPresence(info.currentChannel, connection, info.username, false);
             
             info.currentChannel.clear();
+            info.presenceVersion = 0;
             
             QJsonObject response;
             response["type"] = "leave_success";
-            sendEncryptedToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
+            sendEncryptedToClient(connection, response);
         }
     }
     else if (type == "get_channels") {
-        sendChannelList(socket);
+        sendChannelList(connection);
+    }
+    else if (type == "get_user_list") {
+        // 客户端的成员列表与增量对不上时请求重发快照，不改变频道成员、语音转发和其他成员看到的状态
+        if (!info.currentChannel.isEmpty() && obj["channel"].toString() == info.currentChannel) {
+            info.presenceVersion = 0;
+            if (info.presenceDeltas) {
+                // 版本为0的客户端在合并窗口结束时收到带版本的快照，之后继续接收增量
+                m_dirtyPresence.insert(info.currentChannel);
+                if (!m_presenceTimer->isActive()) {
+                    m_presenceTimer->start(m_presenceWindow);
+                }
+            } else {
+                sendUserList(connection, info.currentChannel);
+            }
+        }
+    }
+    else if (type == "set_channel_settings") {
+        QString channel = obj["channel"].toString();
+        
+        QJsonObject response;
+        if (m_userDatabase->getUserType(info.username) != UserType::Administrator) {
+            response["type"] = "error";
+            response["message"] = "Permission denied - administrator required";
+        } else if (!m_channels.contains(channel)) {
+            response["type"] = "error";
+            response["message"] = "Channel not found";
+        } else if (const ClusterNode *owner = channelOwner(channel)) {
+            response["type"] = "error";
+            response["message"] = QString("Channel is hosted on node %1").arg(owner->id);
+        } else {
+            if (obj.contains("mixing")) {
+                setChannelMixing(channel, obj["mixing"].toBool());
+            }
+            if (obj.contains("last_n")) {
+                setChannelLastN(channel, obj["last_n"].toInt());
+            }
+            auto selector = m_speakerSelectors.constFind(channel);
+            response["type"] = "channel_settings";
+            response["channel"] = channel;
+            response["mixing"] = m_mixChannels.contains(channel);
+            response["last_n"] = selector != m_speakerSelectors.constEnd() ? (*selector)->maxSpeakers() : 0;
+        }
+        sendEncryptedToClient(connection, response);
     }
 }
 
-void VoiceServer::sendToClient(QTcpSocket *socket, const QString &message)
+void VoiceServer::onAuthFinished(const AuthResult &result)
 {
-    if (!socket || !socket->isOpen()) return;
-    
-    QByteArray data = message.toUtf8();
-    data.append('\n'); // 消息分隔符
-    socket->write(data);
-    socket->flush();
+    // 连接可能在认证期间已经断开
+    auto client = m_clients.find(result.connection);
+    if (client == m_clients.end()) return;
+    ClientInfo &info = client.value();
+    info.authPending = false;
+
+    if (result.ok) {
+        m_userDatabase->cacheUser(result.user);
+    }
+
+    if (result.operation == AuthResult::Operation::Register) {
+        if (result.ok) {
+            QJsonObject response;
+            response["type"] = "register_success";
+            sendToClient(result.connection, response);
+        } else {
+            sendError(result.connection, "Registration failed - user may already exist");
+        }
+        return;
+    }
+
+    if (result.ok) {
+        completeLogin(result.connection, info, result.request);
+    } else {
+        sendError(result.connection, "Authentication failed");
+    }
 }
 
-void VoiceServer::sendEncryptedToClient(QTcpSocket *socket, const QString &message)
+void VoiceServer::completeLogin(ConnectionId connection, ClientInfo &info, const QJsonObject &request, bool resumed)
 {
-    if (!socket || !socket->isOpen()) return;
+    QString username = resumed ? info.username : request["username"].toString();
+
+    // 恢复时轮换会话，旧的会话令牌和密钥不再有效
+    if (!info.sessionId.isEmpty()) {
+        m_userDatabase->removeSession(info.sessionId);
+        m_sessionToConnection.remove(info.sessionId);
+    }
+
+    // 生成会话令牌和加密密钥
+    QByteArray sessionToken = CryptoUtils::generateSessionToken();
+    QString sessionId = m_userDatabase->createSession(username, sessionToken);
     
-    if (!m_clients.contains(socket)) return;
+    // 生成会话加密密钥
+    QByteArray sessionKey = CryptoUtils::generateAESKey();
+    m_userDatabase->setSessionKey(sessionId, sessionKey);
     
-    const ClientInfo &info = m_clients[socket];
-    if (!info.isAuthenticated || info.sessionId.isEmpty()) {
-        sendToClient(socket, message);
-        return;
+    // 更新客户端信息
+    info.username = username;
+    info.sessionId = sessionId;
+    setVoiceEndpoint(connection, info, QHostAddress(request["udp_ip"].toString()),
+                     quint16(request["udp_port"].toInt()));
+    info.isAuthenticated = true;
+    if (info.voiceId == 0) {
+        info.voiceId = allocateVoiceId(connection);
     }
     
-    QByteArray sessionKey = m_userDatabase->getSessionKey(info.sessionId);
-    if (sessionKey.isEmpty()) {
-        sendToClient(socket, message);
-        return;
+    m_sessionToConnection[sessionId] = connection;
+    
+    // 发送成功响应（包含会话令牌和加密密钥）
+    QJsonObject response;
+    response["type"] = resumed ? "resume_success" : "login_success";
+    response["voice_port"] = m_voicePort;
+    response["session_id"] = sessionId;
+    response["session_key"] = QString::fromUtf8(sessionKey.toHex());
+    response["voice_id"] = info.voiceId;
+
+    // 每次登录或恢复都签发新票据，旧票据随之作废
+    if (!info.resumeTicket.isEmpty()) {
+        m_resumeTickets.remove(info.resumeTicket);
+        info.resumeTicket.clear();
     }
+    if (m_resumeGrace > 0) {
+        info.resumeTicket = QString::fromUtf8(CryptoUtils::generateSessionToken().toHex());
+        m_resumeTickets.insert(info.resumeTicket, connection);
+        response["resume_ticket"] = info.resumeTicket;
+        response["resume_grace"] = m_resumeGrace;
+    }
+
+    // 恢复的会话仍在原频道中，客户端继续使用原频道密钥
+    if (resumed && !info.currentChannel.isEmpty()) {
+        response["channel"] = info.currentChannel;
+        response["channel_key"] = QString::fromUtf8(m_channelKeys.value(info.currentChannel).toHex());
+    }
+
+    // 客户端支持时，频道成员变化以版本化增量发送
+    info.presenceDeltas = request["presence"].toString() == "delta";
+    if (info.presenceDeltas) {
+        response["presence"] = "delta";
+    }
+
+    // 连接所在的工作线程发送响应后启用会话密钥；客户端请求二进制编码且使用长度前缀分帧时，
+    // 本响应仍为JSON，之后的消息均为二进制
+    m_controlPlane->completeLogin(connection, response, sessionKey,
+                                  request["encoding"].toString() == "binary");
     
-    QByteArray encrypted = CryptoUtils::encryptAES_CBC(message.toUtf8(), sessionKey);
-    if (!encrypted.isEmpty()) {
-        // 使用Base64编码加密数据以安全传输
-        QByteArray encoded = encrypted.toBase64();
-        encoded.append('\n');
-        socket->write(encoded);
-        socket->flush();
+    if (resumed) {
+        qInfo() << "Session resumed:" << username;
+    } else {
+        qInfo() << "User logged in:" << username;
     }
 }
 
-void VoiceServer::broadcastToChannel(const QString &channel, const QByteArray &message)
+void VoiceServer::resumeSession(ConnectionId connection, const QJsonObject &request)
 {
-    broadcastToChannel(channel, message, nullptr);
-}
+    const ClientInfo &pending = m_clients[connection];
+    if (pending.isAuthenticated || pending.authPending) {
+        sendError(connection, "Resume failed - already logged in");
+        return;
+    }
+    const QHostAddress peerAddress = pending.peerAddress;
 
-void VoiceServer::broadcastToChannel(const QString &channel, const QByteArray &message, QTcpSocket *excludeSocket)
-{
-    if (!m_channels.contains(channel)) return;
-    
-    for (QTcpSocket *client : m_channels[channel]) {
-        if (client != excludeSocket) {
-            sendToClient(client, QString::fromUtf8(message));
+    ConnectionId previous = m_resumeTickets.value(request["ticket"].toString());
+    auto old = m_clients.find(previous);
+    if (previous == 0 || previous == connection || old == m_clients.end()) {
+        sendError(connection, "Resume failed - session expired");
+        return;
+    }
+
+    // 服务器可能还没发现旧连接已断开，由新连接接管，旧连接的关闭通知到达时已找不到该客户端
+    ClientInfo info = old.value();
+    if (!info.detached) {
+        m_controlPlane->disconnectClient(previous);
+    }
+    m_clients.erase(old);
+
+    // 以连接为键的索引全部改为指向新连接；转发表在本轮事件处理结束后才重建，语音转发不会中断
+    clearVoiceEndpoint(previous, info);
+    if (info.voiceId != 0) {
+        m_voiceIds.insert(info.voiceId, connection);
+    }
+    if (!info.currentChannel.isEmpty()) {
+        QSet<ConnectionId> &members = m_channels[info.currentChannel];
+        members.remove(previous);
+        members.insert(connection);
+
+        // 混音流ID跟随成员转移，客户端收到的混音流不变
+        auto mixStreams = m_mixStreamIds.find(info.currentChannel);
+        if (mixStreams != m_mixStreamIds.end() && mixStreams->contains(previous)) {
+            quint16 streamId = mixStreams->take(previous);
+            mixStreams->insert(connection, streamId);
+            m_voiceIds.insert(streamId, connection);
+        }
+    }
+
+    info.peerAddress = peerAddress;
+    info.detached = false;
+    info.resumeDeadline = QDeadlineTimer();
+    ClientInfo &current = m_clients[connection];
+    current = info;
+
+    completeLogin(connection, current, request, true);
+
+    // 断线期间的成员变化: 旧客户端重新收到快照，支持增量的客户端在下个合并窗口收到
+    // 其已知版本之后的增量 (旧连接上最后几条消息可能没有送达，以客户端携带的版本为准)
+    if (!current.currentChannel.isEmpty()) {
+        if (current.presenceDeltas) {
+            quint64 known = quint64(request["presence_version"].toInteger());
+            auto presence = m_presence.constFind(current.currentChannel);
+            current.presenceVersion = presence != m_presence.constEnd() && known <= presence->version ? known : 0;
+            m_dirtyPresence.insert(current.currentChannel);
+            if (!m_presenceTimer->isActive()) {
+                m_presenceTimer->start(m_presenceWindow);
+            }
+        } else {
+            sendUserList(connection, current.currentChannel);
         }
     }
 }
 
-void VoiceServer::broadcastVoiceToChannel(const QString &channel, const QByteArray &audioData, QTcpSocket *sender)
+void VoiceServer::sendError(ConnectionId connection, const QString &message)
 {
-    if (!m_channels.contains(channel)) return;
-    
-    for (QTcpSocket *client : m_channels[channel]) {
-        if (client != sender && m_clients.contains(client)) {
-            const ClientInfo &info = m_clients[client];
-            if (info.udpPort > 0 && info.isAuthenticated) {
-                // 直接转发音频数据（客户端之间端到端加密）
-                m_voiceSocket->writeDatagram(audioData, info.udpAddress, info.udpPort);
-            }
+    QJsonObject response;
+    response["type"] = "error";
+    response["message"] = message;
+    sendToClient(connection, response);
+}
+
+void VoiceServer::sendToClient(ConnectionId connection, const QJsonObject &message)
+{
+    m_controlPlane->send(connection, message);
+}
+
+void VoiceServer::sendEncryptedToClient(ConnectionId connection, const QJsonObject &message,
+                                        ControlPlane::Flush flush)
+{
+    m_controlPlane->sendEncrypted(connection, message, flush);
+}
+
+void VoiceServer::broadcastToChannel(const QString &channel, const QJsonObject &message)
+{
+    broadcastToChannel(channel, message, 0);
+}
+
+void VoiceServer::broadcastToChannel(const QString &channel, const QJsonObject &message, ConnectionId exclude)
+{
+    auto members = m_channels.constFind(channel);
+    if (members == m_channels.constEnd()) return;
+
+    QVector<ConnectionId> recipients;
+    recipients.reserve(members->size());
+    for (ConnectionId client : *members) {
+        if (client != exclude) {
+            recipients.append(client);
         }
     }
+    broadcastToClients(recipients, message);
 }
 
-void VoiceServer::sendChannelList(QTcpSocket *socket)
+void VoiceServer::broadcastToClients(const QVector<ConnectionId> &recipients, const QJsonObject &message)
+{
+    // 由各连接所在的工作线程序列化，并为有会话密钥的连接批量加密
+    m_controlPlane->broadcast(recipients, message);
+}
+
+void VoiceServer::sendChannelList(ConnectionId connection)
 {
     QJsonObject response;
     response["type"] = "channel_list";
@@ -388,28 +663,341 @@ void VoiceServer::sendChannelList(QTcpSocket *socket)
         QJsonObject ch;
         ch["name"] = channel;
         ch["user_count"] = m_channels[channel].size();
+        ch["mixing"] = m_mixChannels.contains(channel);
+        auto selector = m_speakerSelectors.constFind(channel);
+        ch["last_n"] = selector != m_speakerSelectors.constEnd() ? (*selector)->maxSpeakers() : 0;
+        if (const ClusterNode *owner = m_clusterRing.ownerOf(channel)) {
+            ch["node"] = owner->id;
+        }
         channels.append(ch);
     }
     response["channels"] = channels;
     
-    sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
+    sendToClient(connection, response);
 }
 
-void VoiceServer::sendUserList(QTcpSocket *socket, const QString &channel)
+void VoiceServer::sendUserList(ConnectionId connection, const QString &channel)
 {
     if (!m_channels.contains(channel)) return;
     
+    sendToClient(connection, userListMessage(channel));
+}
+
+QJsonObject VoiceServer::userListMessage(const QString &channel) const
+{
     QJsonObject response;
     response["type"] = "user_list";
     response["channel"] = channel;
     
     QJsonArray users;
-    for (QTcpSocket *client : m_channels[channel]) {
-        if (m_clients.contains(client)) {
-            users.append(m_clients[client].username);
+    auto members = m_channels.constFind(channel);
+    if (members != m_channels.constEnd()) {
+        for (ConnectionId client : *members) {
+            auto info = m_clients.constFind(client);
+            if (info != m_clients.constEnd()) {
+                users.append(info->username);
+            }
         }
     }
     response["users"] = users;
-    
-    sendToClient(socket, QJsonDocument(response).toJson(QJsonDocument::Compact));
+
+    auto presence = m_presence.constFind(channel);
+    if (presence != m_presence.constEnd()) {
+        response["version"] = qint64(presence->version);
+    }
+    return response;
+}
+
+void VoiceServer::recordPresence(const QString &channel, ConnectionId connection, const QString &username, bool joined)
+{
+    QJsonObject msg;
+    msg["type"] = joined ? "user_joined" : "user_left";
+    msg["username"] = username;
+    msg["channel"] = channel;
+
+    // 旧客户端立即收到单条通知
+    QVector<ConnectionId> legacy;
+    auto members = m_channels.constFind(channel);
+    if (members != m_channels.constEnd()) {
+        for (ConnectionId client : *members) {
+            auto info = m_clients.constFind(client);
+            if (client != connection && info != m_clients.constEnd() && !info->presenceDeltas) {
+                legacy.append(client);
+            }
+        }
+    }
+    if (!legacy.isEmpty()) {
+        broadcastToClients(legacy, msg);
+    }
+
+    // 支持增量的客户端: 合并到本窗口的变化中，窗口结束时统一发布
+    ChannelPresence &presence = m_presence[channel];
+    applyPresence(&presence.pendingJoined, &presence.pendingLeft, username, joined);
+    m_dirtyPresence.insert(channel);
+    if (!m_presenceTimer->isActive()) {
+        m_presenceTimer->start(m_presenceWindow);
+    }
+}
+
+void VoiceServer::flushPresence()
+{
+    const QSet<QString> channels = std::exchange(m_dirtyPresence, QSet<QString>());
+    for (const QString &channel : channels) {
+        ChannelPresence &presence = m_presence[channel];
+
+        // 本窗口的所有变化发布为一个新版本
+        if (!presence.pendingJoined.isEmpty() || !presence.pendingLeft.isEmpty()) {
+            ChannelPresence::Delta delta;
+            delta.version = ++presence.version;
+            delta.joined = std::exchange(presence.pendingJoined, QStringList());
+            delta.left = std::exchange(presence.pendingLeft, QStringList());
+            presence.history.append(delta);
+            if (presence.history.size() > PRESENCE_HISTORY) {
+                presence.history.removeFirst();
+            }
+        }
+
+        auto members = m_channels.constFind(channel);
+        if (members == m_channels.constEnd()) continue;
+
+        // 按客户端已知的版本分组，同一组共享同一条消息 (通常只有 "上一版本" 和 "新加入" 两组)
+        QMap<quint64, QVector<ConnectionId>> byVersion;
+        for (ConnectionId client : *members) {
+            auto info = m_clients.find(client);
+            // 断线的客户端保持已知版本，恢复后再补发
+            if (info == m_clients.end() || !info->presenceDeltas || info->detached
+                || info->presenceVersion == presence.version) {
+                continue;
+            }
+            byVersion[info->presenceVersion].append(client);
+            info->presenceVersion = presence.version;
+        }
+
+        for (auto group = byVersion.cbegin(); group != byVersion.cend(); ++group) {
+            const quint64 known = group.key();
+
+            // 历史中缺少所需的版本，或者合并后的增量比完整列表还大时，改发快照
+            bool useSnapshot = known == 0 || presence.history.isEmpty()
+                               || presence.history.first().version > known + 1;
+            QStringList joined;
+            QStringList left;
+            if (!useSnapshot) {
+                for (const ChannelPresence::Delta &delta : std::as_const(presence.history)) {
+                    if (delta.version <= known) continue;
+                    for (const QString &username : delta.left) {
+                        applyPresence(&joined, &left, username, false);
+                    }
+                    for (const QString &username : delta.joined) {
+                        applyPresence(&joined, &left, username, true);
+                    }
+                }
+                useSnapshot = joined.size() + left.size() > members->size();
+            }
+
+            if (useSnapshot) {
+                broadcastToClients(group.value(), userListMessage(channel));
+                continue;
+            }
+
+            QJsonObject msg;
+            msg["type"] = "presence_delta";
+            msg["channel"] = channel;
+            msg["from_version"] = qint64(known);
+            msg["version"] = qint64(presence.version);
+            msg["joined"] = QJsonArray::fromStringList(joined);
+            msg["left"] = QJsonArray::fromStringList(left);
+            broadcastToClients(group.value(), msg);
+        }
+    }
+}
+
+void VoiceServer::setVoiceEndpoint(ConnectionId connection, ClientInfo &info, const QHostAddress &address, quint16 port)
+{
+    clearVoiceEndpoint(connection, info);
+
+    // 客户端未指定地址时 (0.0.0.0)，使用控制连接的实际对端地址
+    QHostAddress resolved = address;
+    if (resolved.isNull() || resolved == QHostAddress::AnyIPv4 || resolved == QHostAddress::AnyIPv6) {
+        resolved = info.peerAddress;
+    }
+
+    info.udpAddress = resolved;
+    info.udpPort = port;
+    if (port == 0) return;
+
+    // 同一端点被新客户端占用时，以新客户端为准
+    VoiceEndpoint endpoint = VoiceEndpoint::fromAddress(resolved, port);
+    ConnectionId previousOwner = m_voiceEndpoints.value(endpoint);
+    if (previousOwner && previousOwner != connection && m_clients.contains(previousOwner)) {
+        scheduleVoiceRoutesUpdate(m_clients[previousOwner].currentChannel);
+    }
+    m_voiceEndpoints.insert(endpoint, connection);
+    scheduleVoiceRoutesUpdate(info.currentChannel);
+}
+
+void VoiceServer::clearVoiceEndpoint(ConnectionId connection, ClientInfo &info)
+{
+    if (info.udpPort == 0) return;
+
+    VoiceEndpoint endpoint = VoiceEndpoint::fromAddress(info.udpAddress, info.udpPort);
+    auto it = m_voiceEndpoints.find(endpoint);
+    if (it != m_voiceEndpoints.end() && it.value() == connection) {
+        m_voiceEndpoints.erase(it);
+    }
+    info.udpAddress.clear();
+    info.udpPort = 0;
+    scheduleVoiceRoutesUpdate(info.currentChannel);
+}
+
+quint16 VoiceServer::allocateVoiceId(ConnectionId connection)
+{
+    // 依次分配，跳过正在使用的ID和表示未分配的0，尽量推迟ID的复用
+    if (m_voiceIds.size() >= 0xFFFF) return 0;
+    while (m_nextVoiceId == VoicePacket::SERVER_SENDER_ID || m_voiceIds.contains(m_nextVoiceId)) {
+        m_nextVoiceId++;
+    }
+    quint16 id = m_nextVoiceId++;
+    m_voiceIds.insert(id, connection);
+    return id;
+}
+
+void VoiceServer::updateMixStreams(const QString &channel)
+{
+    // 混音频道中每个成员发言时收到一路不含自己声音的混音，由该发言者自己的编码器生成，
+    // 因此每个成员使用一个单独的混音流ID；成员离开频道或频道关闭混音时释放
+    const bool mixing = m_mixChannels.contains(channel);
+    auto members = m_channels.constFind(channel);
+    QHash<ConnectionId, quint16> &streams = m_mixStreamIds[channel];
+
+    for (auto it = streams.begin(); it != streams.end();) {
+        if (!mixing || members == m_channels.constEnd() || !members->contains(it.key())) {
+            m_voiceIds.remove(it.value());
+            it = streams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (mixing && members != m_channels.constEnd()) {
+        for (ConnectionId member : *members) {
+            if (streams.contains(member)) continue;
+            quint16 streamId = allocateVoiceId(member);
+            if (streamId != 0) {
+                streams.insert(member, streamId);
+            }
+        }
+    }
+    if (streams.isEmpty()) {
+        m_mixStreamIds.remove(channel);
+    }
+}
+
+void VoiceServer::scheduleVoiceRoutesUpdate(const QString &channel)
+{
+    if (channel.isEmpty()) return;
+
+    // 同一事件循环迭代内的多次成员变化合并为一次发布
+    bool scheduled = !m_dirtyVoiceChannels.isEmpty();
+    m_dirtyVoiceChannels.insert(channel);
+    if (!scheduled) {
+        QMetaObject::invokeMethod(this, &VoiceServer::publishVoiceRoutes, Qt::QueuedConnection);
+    }
+}
+
+VoiceChannelRoutePtr VoiceServer::buildChannelRoute(const QString &channel) const
+{
+    auto members = m_channels.constFind(channel);
+    if (members == m_channels.constEnd()) return nullptr;
+
+    auto route = std::make_shared<VoiceChannelRoute>();
+    route->destinations.reserve(members->size());
+    route->endpoints.reserve(members->size());
+    const QHash<ConnectionId, quint16> mixStreams = m_mixStreamIds.value(channel);
+
+    for (ConnectionId client : *members) {
+        auto info = m_clients.constFind(client);
+        if (info == m_clients.constEnd() || info->udpPort == 0 || !info->isAuthenticated) continue;
+
+        // 端点已被其他客户端占用时不再属于该成员
+        VoiceEndpoint endpoint = VoiceEndpoint::fromAddress(info->udpAddress, info->udpPort);
+        if (m_voiceEndpoints.value(endpoint) != client) continue;
+
+        route->endpoints.append(endpoint);
+        route->voiceIds.append(info->voiceId);
+        route->mixStreamIds.append(mixStreams.value(client));
+        route->destinations.append(VoiceDestination::fromEndpoint(endpoint));
+    }
+
+    if (route->endpoints.isEmpty()) return nullptr;
+    route->mix = m_mixChannels.value(channel);
+    route->speakerSelector = m_speakerSelectors.value(channel);
+    return route;
+}
+
+const ClusterNode *VoiceServer::channelOwner(const QString &channel) const
+{
+    const ClusterNode *owner = m_clusterRing.ownerOf(channel);
+    return owner && owner->id != m_nodeId ? owner : nullptr;
+}
+
+void VoiceServer::setChannelMixing(const QString &channel, bool enabled)
+{
+    if (enabled == m_mixChannels.contains(channel)) return;
+
+    if (enabled) {
+        // 服务器持有频道密钥，混音模式下解密、混音后再用同一密钥加密
+        // 非发言听众共享的混音流也使用单独分配的发送者ID，不属于任何连接
+        quint16 sharedStreamId = allocateVoiceId(0);
+        if (sharedStreamId == 0) {
+            qWarning() << "No voice sender ID left for mixing channel" << channel;
+            return;
+        }
+        m_mixChannels.insert(channel, std::make_shared<VoiceMixChannel>(m_channelKeys.value(channel), sharedStreamId));
+    } else {
+        std::shared_ptr<VoiceMixChannel> mix = m_mixChannels.take(channel);
+        m_voiceIds.remove(mix->sharedStreamId());
+    }
+    scheduleVoiceRoutesUpdate(channel);
+    qInfo() << "Channel" << channel << "mixing:" << (enabled ? "on" : "off");
+}
+
+void VoiceServer::setChannelLastN(const QString &channel, int lastN)
+{
+    // 0 表示不限制，转发所有发言者
+    if (lastN <= 0) {
+        if (!m_speakerSelectors.remove(channel)) return;
+    } else {
+        auto selector = m_speakerSelectors.constFind(channel);
+        if (selector != m_speakerSelectors.constEnd() && (*selector)->maxSpeakers() == lastN) return;
+        m_speakerSelectors.insert(channel, std::make_shared<VoiceSpeakerSelector>(lastN));
+    }
+    scheduleVoiceRoutesUpdate(channel);
+    qInfo() << "Channel" << channel << "forwarding speakers limit:" << qMax(lastN, 0);
+}
+
+void VoiceServer::publishVoiceRoutes()
+{
+    // 只重建发生变化的频道，其余频道的转发表沿用上一个快照
+    for (const QString &channel : std::as_const(m_dirtyVoiceChannels)) {
+        updateMixStreams(channel);
+        VoiceChannelRoutePtr route = buildChannelRoute(channel);
+        if (route) {
+            m_channelRoutes.insert(channel, std::move(route));
+        } else {
+            m_channelRoutes.remove(channel);
+        }
+    }
+    m_dirtyVoiceChannels.clear();
+
+    auto routes = std::make_shared<VoiceRoutes>();
+    routes->channels.reserve(m_channelRoutes.size());
+    for (const VoiceChannelRoutePtr &route : std::as_const(m_channelRoutes)) {
+        int channel = routes->channels.size();
+        routes->channels.append(route);
+        for (int slot = 0; slot < route->endpoints.size(); ++slot) {
+            routes->senders.insert(route->endpoints.at(slot),
+                                   VoiceRoutes::Sender{channel, slot, route->voiceIds.at(slot)});
+        }
+    }
+
+    m_voicePlane->publishRoutes(std::move(routes));
 }
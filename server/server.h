@@ -2,24 +2,56 @@
 #define SERVER_H
 
 #include <QObject>
-#include <QTcpServer>
-#include <QUdpSocket>
+#include <QDeadlineTimer>
+#include <QHostAddress>
 #include <QMap>
+#include <QHash>
 #include <QSet>
+#include <QStringList>
+#include <QVector>
+#include "clusterring.h"
+#include "controlplane.h"
+#include "voiceendpoint.h"
+#include "voiceplane.h"
 
-class QTcpSocket;
+class QJsonObject;
+class QTimer;
+class AuthService;
 class UserDatabase;
+struct AuthResult;
+struct UserCredentials;
 
 struct ClientInfo {
-    QTcpSocket *controlSocket = nullptr;
+    QHostAddress peerAddress; // 控制连接的对端地址
     QString username;
     QString sessionId;
     QString currentChannel;
     QHostAddress udpAddress;
     quint16 udpPort = 0;
-    quint64 audioCounter = 0; // 用于UDP音频加密的计数器
+    quint16 voiceId = 0; // 语音数据包头部中的发送者ID，登录时分配，0 表示未分配
     bool isConnected = false;
     bool isAuthenticated = false;
+    bool authPending = false; // 登录或注册请求正在认证线程池中处理
+    bool presenceDeltas = false; // 登录时协商: 以版本化增量接收频道成员变化
+    quint64 presenceVersion = 0; // 已发给该客户端的当前频道成员版本，0 表示尚未发送快照
+    QString resumeTicket; // 断线后凭此票据恢复会话，空表示不可恢复 (未登录、已注销或未启用)
+    bool detached = false; // 控制连接已断开，会话、频道成员和语音转发保留到 resumeDeadline
+    QDeadlineTimer resumeDeadline;
+};
+
+// 频道成员 (在线状态) 的版本历史
+// 同一合并窗口内的加入/离开合并为一个版本的增量；版本从1开始，0 表示客户端没有任何状态
+struct ChannelPresence {
+    struct Delta {
+        quint64 version = 0; // 应用本增量后的版本
+        QStringList joined;
+        QStringList left;
+    };
+
+    quint64 version = 1;
+    QStringList pendingJoined; // 本窗口内尚未发布的变化
+    QStringList pendingLeft;
+    QVector<Delta> history; // 最近发布的增量，落后更多的客户端改为接收快照
 };
 
 class VoiceServer : public QObject
@@ -32,29 +64,102 @@ public:
     bool startServer(quint16 controlPort, quint16 voicePort);
     void stopServer();
 
+    // 选择语音端口的I/O后端，需在 startServer 之前调用
+    void setVoiceIoBackend(VoiceIoBackend backend) { m_voiceIoBackend = backend; }
+
+    // 语音转发线程数 (0 = 在控制事件循环上转发)，需在 startServer 之前调用
+    void setVoiceThreads(int threads) { m_voiceThreads = threads; }
+
+    // 控制连接工作线程数 (0 = 在主线程处理所有控制连接)，需在 startServer 之前调用
+    void setControlThreads(int threads) { m_controlThreads = threads; }
+
+    // 认证线程池的线程数和排队上限，超过上限的登录/注册请求被拒绝，需在 startServer 之前调用
+    void setAuthThreads(int threads) { m_authThreads = threads; }
+    void setAuthQueueLimit(int limit) { m_authQueueLimit = limit; }
+
+    // 用户数据库路径，集群中的所有节点应指向同一个数据库，需在 startServer 之前调用
+    void setDatabasePath(const QString &path) { m_databasePath = path; }
+
+    // 集群模式: 按一致性哈希把频道分配给各节点，加入其他节点的频道时把客户端重定向过去
+    void setCluster(const QString &nodeId, const QVector<ClusterNode> &nodes);
+
+    // 频道成员变化的合并窗口 (毫秒)，窗口内的所有加入/离开作为一个增量发布
+    void setPresenceWindow(int ms) { m_presenceWindow = qMax(0, ms); }
+
+    // 会话恢复的宽限期 (秒)，控制连接断开后在此期间内可凭票据恢复，0 = 禁用
+    void setResumeGrace(int seconds) { m_resumeGrace = qMax(0, seconds); }
+
 private slots:
-    void onNewConnection();
-    void onClientDisconnected();
-    void onControlDataReceived();
-    void onVoiceDataReceived();
+    void onConnectionOpened(ConnectionId connection, const QHostAddress &peerAddress);
+    void onConnectionClosed(ConnectionId connection);
+    void handleControlMessage(ConnectionId connection, const QJsonObject &obj);
+    void reportVoiceIoStats();
+    void reportControlIoStats();
+    void reportAuthStats();
+    void onAuthFinished(const AuthResult &result);
+    void publishVoiceRoutes();
+    void flushPresence();
+    void expireDetachedSessions();
 
 private:
-    void handleControlMessage(QTcpSocket *socket, const QByteArray &data);
-    void sendToClient(QTcpSocket *socket, const QString &message);
-    void sendEncryptedToClient(QTcpSocket *socket, const QString &message);
-    void broadcastToChannel(const QString &channel, const QByteArray &message);
-    void broadcastToChannel(const QString &channel, const QByteArray &message, QTcpSocket *excludeSocket);
-    void broadcastVoiceToChannel(const QString &channel, const QByteArray &audioData, QTcpSocket *sender);
-    void sendChannelList(QTcpSocket *socket);
-    void sendUserList(QTcpSocket *socket, const QString &channel);
+    void completeLogin(ConnectionId connection, ClientInfo &info, const QJsonObject &request, bool resumed = false);
+    void resumeSession(ConnectionId connection, const QJsonObject &request);
+    void releaseClient(ConnectionId connection);
+    void sendError(ConnectionId connection, const QString &message);
+    void sendToClient(ConnectionId connection, const QJsonObject &message);
+    void sendEncryptedToClient(ConnectionId connection, const QJsonObject &message,
+                               ControlPlane::Flush flush = ControlPlane::Flush::Deferred);
+    void broadcastToChannel(const QString &channel, const QJsonObject &message);
+    void broadcastToChannel(const QString &channel, const QJsonObject &message, ConnectionId exclude);
+    void broadcastToClients(const QVector<ConnectionId> &recipients, const QJsonObject &message);
+    void sendChannelList(ConnectionId connection);
+    void sendUserList(ConnectionId connection, const QString &channel);
+    QJsonObject userListMessage(const QString &channel) const;
+    void recordPresence(const QString &channel, ConnectionId connection, const QString &username, bool joined);
+    void setChannelMixing(const QString &channel, bool enabled);
+    void setChannelLastN(const QString &channel, int lastN);
+    void setVoiceEndpoint(ConnectionId connection, ClientInfo &info, const QHostAddress &address, quint16 port);
+    void clearVoiceEndpoint(ConnectionId connection, ClientInfo &info);
+    quint16 allocateVoiceId(ConnectionId connection);
+    void updateMixStreams(const QString &channel);
+    void scheduleVoiceRoutesUpdate(const QString &channel);
+    VoiceChannelRoutePtr buildChannelRoute(const QString &channel) const;
+    const ClusterNode *channelOwner(const QString &channel) const; // 本节点拥有该频道时返回nullptr
     
-    QTcpServer *m_controlServer;
-    QUdpSocket *m_voiceSocket;
-    QMap<QTcpSocket*, ClientInfo> m_clients;
-    QMap<QString, QSet<QTcpSocket*>> m_channels; // channel -> set of clients
+    ControlPlane *m_controlPlane;
+    VoicePlane *m_voicePlane;
+    VoiceIoBackend m_voiceIoBackend = VoiceIoBackend::Qt;
+    int m_voiceThreads = 0;
+    int m_controlThreads = 0;
+    int m_authThreads = 2;
+    int m_authQueueLimit = 256;
+    QSet<QString> m_dirtyVoiceChannels; // 待重建转发表的频道
+    QHash<QString, VoiceChannelRoutePtr> m_channelRoutes; // channel -> 已构建的转发表
+    VoiceIoStats m_reportedIoStats;
+    ControlIoStats m_reportedControlStats;
+    QTimer *m_statsTimer;
+    QHash<QString, ChannelPresence> m_presence; // channel -> 成员版本历史
+    QSet<QString> m_dirtyPresence; // 本窗口内有成员变化的频道
+    QTimer *m_presenceTimer;
+    int m_presenceWindow = 100;
+    QHash<QString, ConnectionId> m_resumeTickets; // resume ticket -> connection
+    QTimer *m_resumeTimer; // 检查宽限期已过的断线会话，只在有断线会话时运行
+    int m_resumeGrace = 30;
+    QHash<ConnectionId, ClientInfo> m_clients;
+    QHash<VoiceEndpoint, ConnectionId> m_voiceEndpoints; // UDP端点 -> client (发送者索引)
+    QHash<quint16, ConnectionId> m_voiceIds; // 已分配的语音发送者ID -> client (混音流的ID也在其中，共享流为0)
+    quint16 m_nextVoiceId = 1;
+    QMap<QString, QSet<ConnectionId>> m_channels; // channel -> set of clients
     QMap<QString, QByteArray> m_channelKeys; // channel -> encryption key
-    QMap<QString, QTcpSocket*> m_sessionToSocket; // sessionId -> socket
+    QHash<QString, std::shared_ptr<VoiceMixChannel>> m_mixChannels; // 混音模式的频道
+    QHash<QString, QHash<ConnectionId, quint16>> m_mixStreamIds; // 混音频道 -> 成员发言时收到的混音流ID
+    QHash<QString, std::shared_ptr<VoiceSpeakerSelector>> m_speakerSelectors; // 限制转发发言者数的频道
+    QMap<QString, ConnectionId> m_sessionToConnection; // sessionId -> connection
     UserDatabase *m_userDatabase;
+    AuthService *m_authService;
+    QString m_databasePath = "voicephone.db";
+    QString m_nodeId;
+    ClusterRing m_clusterRing;
     quint16 m_voicePort;
 };
 
@@ -0,0 +1,88 @@
+#include "speakerselector.h"
+#include "../src/voicepacket.h"
+#include <QMutexLocker>
+#include <limits>
+
+using namespace std::chrono_literals;
+
+static constexpr auto HYSTERESIS_WINDOW = 500ms;   // 被选中后的最短保持时间 / 判定沉默的时间
+static constexpr auto SPEAKER_EXPIRY = 10s;        // 超过该时间无音频的发言者从表中移除
+static constexpr double REPLACE_MARGIN_DB = 6.0;   // 替换已选发言者所需的响度优势
+static constexpr double MIN_LOUDNESS_DB = 57.0;    // 占用空闲位置所需的最低响度 (-70 dBov)
+static constexpr double SMOOTHING = 0.2;           // 响度指数平滑系数
+static constexpr quint32 PRUNE_INTERVAL_PACKETS = 1024;
+
+VoiceSpeakerSelector::VoiceSpeakerSelector(int maxSpeakers)
+    : m_maxSpeakers(maxSpeakers)
+{
+}
+
+bool VoiceSpeakerSelector::admit(const VoiceEndpoint &speaker, quint8 level, Clock::time_point now)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (++m_packetsSincePrune >= PRUNE_INTERVAL_PACKETS) {
+        prune(now);
+    }
+
+    SpeakerState &state = m_speakers[speaker];
+    double loudness = double(VoicePacket::LEVEL_SILENT) - double(qMin(level, VoicePacket::LEVEL_SILENT));
+    if (state.lastPacket == Clock::time_point()) {
+        state.loudness = loudness;
+    } else {
+        state.loudness += SMOOTHING * (loudness - state.loudness);
+    }
+    state.lastPacket = now;
+
+    if (state.selected) return true;
+
+    if (m_selected.size() < m_maxSpeakers) {
+        state.selected = true;
+        state.selectedSince = now;
+        m_selected.append(speaker);
+        return true;
+    }
+
+    // 找出最弱的已选发言者，沉默超过滞后窗口的优先被替换
+    int weakest = -1;
+    bool weakestSilent = false;
+    double weakestLoudness = std::numeric_limits<double>::max();
+    for (int i = 0; i < m_selected.size(); ++i) {
+        const SpeakerState &candidate = m_speakers[m_selected.at(i)];
+        bool silent = now - candidate.lastPacket > HYSTERESIS_WINDOW;
+        double score = silent ? std::numeric_limits<double>::lowest() : candidate.loudness;
+        if (score < weakestLoudness) {
+            weakest = i;
+            weakestSilent = silent;
+            weakestLoudness = score;
+        }
+    }
+    if (weakest < 0 || state.loudness < MIN_LOUDNESS_DB) return false;
+
+    SpeakerState &replaced = m_speakers[m_selected.at(weakest)];
+    bool louder = state.loudness > weakestLoudness + REPLACE_MARGIN_DB
+                  && now - replaced.selectedSince > HYSTERESIS_WINDOW;
+    if (!weakestSilent && !louder) return false;
+
+    replaced.selected = false;
+    state.selected = true;
+    state.selectedSince = now;
+    m_selected[weakest] = speaker;
+    return true;
+}
+
+void VoiceSpeakerSelector::prune(Clock::time_point now)
+{
+    m_packetsSincePrune = 0;
+
+    for (auto it = m_speakers.begin(); it != m_speakers.end();) {
+        if (now - it->lastPacket > SPEAKER_EXPIRY) {
+            if (it->selected) {
+                m_selected.removeOne(it.key());
+            }
+            it = m_speakers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
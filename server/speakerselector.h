@@ -0,0 +1,49 @@
+#ifndef SPEAKERSELECTOR_H
+#define SPEAKERSELECTOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <chrono>
+#include "voiceendpoint.h"
+
+/**
+ * @brief 最响N个发言者的选择器 (Last-N)
+ *
+ * 根据客户端在数据包明文头部携带的音频电平，每个频道只转发当前最响的N个发言者。
+ * 为避免频繁切换，新发言者必须比已选中的最弱发言者明显更响，
+ * 且被替换者已被选中超过滞后窗口，才会发生替换；
+ * 已选中的发言者在滞后窗口内没有音频时，其位置可以被直接占用。
+ *
+ * 可在多个转发线程中并发调用。
+ */
+class VoiceSpeakerSelector
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit VoiceSpeakerSelector(int maxSpeakers);
+
+    int maxSpeakers() const { return m_maxSpeakers; }
+
+    // 返回该数据包是否应被转发; level 为RFC 6464电平 (-dBov)
+    bool admit(const VoiceEndpoint &speaker, quint8 level, Clock::time_point now = Clock::now());
+
+private:
+    struct SpeakerState {
+        double loudness = 0.0;        // 平滑后的响度 (dB，越大越响)
+        Clock::time_point lastPacket;
+        Clock::time_point selectedSince;
+        bool selected = false;
+    };
+
+    void prune(Clock::time_point now);
+
+    const int m_maxSpeakers;
+    QMutex m_lock;
+    QHash<VoiceEndpoint, SpeakerState> m_speakers;
+    QVector<VoiceEndpoint> m_selected;
+    quint32 m_packetsSincePrune = 0;
+};
+
+#endif // SPEAKERSELECTOR_H
@@ -0,0 +1,344 @@
+#include "uringvoicetransport.h"
+#include <QSocketNotifier>
+#include <QDebug>
+#include <liburing.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr unsigned RING_ENTRIES = 256;
+constexpr unsigned RECV_BUFFERS = 256;  // provided buffer ring 的大小必须是2的幂
+constexpr int BUFFER_GROUP = 0;
+
+constexpr quint64 RECV_TAG = 1;
+constexpr quint64 SEND_TAG = 2;
+
+// 多发recvmsg的缓冲区布局: io_uring_recvmsg_out + 源地址 + 数据
+constexpr unsigned RECV_BUFFER_SIZE =
+    unsigned(sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in6) + VoiceBufferPool::BUFFER_SIZE);
+
+QString errnoString(int error)
+{
+    return QString::fromLocal8Bit(std::strerror(error));
+}
+
+// 探测所需的内核特性，只执行一次
+bool probeUring(QString *reason)
+{
+    io_uring ring;
+    int ret = io_uring_queue_init(8, &ring, 0);
+    if (ret < 0) {
+        *reason = "io_uring_queue_init: " + errnoString(-ret);
+        return false;
+    }
+
+    bool supported = false;
+    io_uring_probe *probe = io_uring_get_probe_ring(&ring);
+    io_uring_buf_ring *bufRing = nullptr;
+    int fd = -1;
+
+    if (!(ring.features & IORING_FEAT_SUBMIT_STABLE)) {
+        *reason = "kernel lacks IORING_FEAT_SUBMIT_STABLE";
+    } else if (!probe || !io_uring_opcode_supported(probe, IORING_OP_RECVMSG)
+               || !io_uring_opcode_supported(probe, IORING_OP_SENDMSG)) {
+        *reason = "kernel does not support IORING_OP_RECVMSG / IORING_OP_SENDMSG";
+    } else if (!(bufRing = io_uring_setup_buf_ring(&ring, 1, BUFFER_GROUP, 0, &ret))) {
+        *reason = "provided buffer rings are not supported: " + errnoString(-ret);
+    } else if ((fd = ::socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        *reason = "socket: " + errnoString(errno);
+    } else {
+        // 不支持多发recvmsg的内核在提交时立即以 -EINVAL 完成
+        msghdr msg = {};
+        msg.msg_namelen = sizeof(sockaddr_in6);
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_recvmsg_multishot(sqe, fd, &msg, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        io_uring_submit(&ring);
+
+        io_uring_cqe *cqe = nullptr;
+        if (io_uring_peek_cqe(&ring, &cqe) == 0 && cqe->res < 0) {
+            *reason = "multishot recvmsg is not supported: " + errnoString(-cqe->res);
+        } else {
+            supported = true;
+        }
+    }
+
+    if (probe) io_uring_free_probe(probe);
+    if (bufRing) io_uring_free_buf_ring(&ring, bufRing, 1, BUFFER_GROUP);
+    io_uring_queue_exit(&ring);
+    if (fd >= 0) ::close(fd);
+    return supported;
+}
+
+/**
+ * io_uring后端:
+ * - 接收: 一个常驻的多发recvmsg，内核直接把数据包写入provided buffer ring，
+ *   完成事件通过eventfd唤醒事件循环，读完即把缓冲区归还环中，全程无需逐包系统调用。
+ * - 发送: 整个转发集合作为一批sendmsg SQE，一次 io_uring_submit 提交。
+ *   发送带MSG_DONTWAIT且不使用SQPOLL，因此在提交时同步执行 (缓冲区满时以-EAGAIN完成而不是挂起)，
+ *   提交返回后内核不再引用数据和消息头。成功的发送不产生完成事件 (IOSQE_CQE_SKIP_SUCCESS)。
+ */
+class UringVoiceTransport : public VoiceTransport
+{
+public:
+    explicit UringVoiceTransport(QObject *parent)
+        : VoiceTransport(parent)
+    {
+    }
+
+    ~UringVoiceTransport() override { close(); }
+
+    bool bind(quint16 port, bool reusePort) override
+    {
+        close();
+
+        m_fd = openSocket(port, reusePort, &m_error);
+        if (m_fd < 0) return false;
+
+        if (!setupRing()) {
+            close();
+            return false;
+        }
+
+        armReceive();
+        io_uring_submit(&m_ring);
+
+        m_notifier = new QSocketNotifier(m_eventFd, QSocketNotifier::Read, this);
+        QObject::connect(m_notifier, &QSocketNotifier::activated, this, [this]() { onCompletion(); });
+        return true;
+    }
+
+    void close() override
+    {
+        delete m_notifier;
+        m_notifier = nullptr;
+        if (m_ringReady) {
+            if (m_bufRing) {
+                io_uring_free_buf_ring(&m_ring, m_bufRing, RECV_BUFFERS, BUFFER_GROUP);
+                m_bufRing = nullptr;
+            }
+            io_uring_queue_exit(&m_ring);
+            m_ringReady = false;
+        }
+        if (m_eventFd >= 0) {
+            ::close(m_eventFd);
+            m_eventFd = -1;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    QString errorString() const override { return m_error; }
+    const char *name() const override { return "uring"; }
+
+    void send(const char *data, qsizetype size,
+              const VoiceDestination *destinations, qsizetype count, qsizetype skip) override
+    {
+        if (m_fd < 0 || count <= 0) return;
+
+        iovec iov;
+        iov.iov_base = const_cast<char *>(data);
+        iov.iov_len = size_t(size);
+
+        qsizetype next = 0;
+        while (next < count) {
+            unsigned batch = 0;
+            for (; next < count && batch < RING_ENTRIES; ++next) {
+                if (next == skip) continue;
+                io_uring_sqe *sqe = io_uring_get_sqe(&m_ring);
+                if (!sqe) break;
+
+                // 目标地址已预先转换，直接引用而不复制
+                msghdr &hdr = m_txMsgs[batch++];
+                hdr = {};
+                hdr.msg_name = const_cast<sockaddr_in6 *>(&destinations[next].sockAddress);
+                hdr.msg_namelen = sizeof(sockaddr_in6);
+                hdr.msg_iov = &iov;
+                hdr.msg_iovlen = 1;
+
+                io_uring_prep_sendmsg(sqe, m_fd, &hdr, MSG_DONTWAIT);
+                sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+                io_uring_sqe_set_data64(sqe, SEND_TAG);
+            }
+            if (batch == 0) break;
+
+            int submitted = io_uring_submit(&m_ring);
+            m_stats.sendCalls++;
+            if (submitted > 0) m_sendsSubmitted += quint64(submitted);
+        }
+    }
+
+    VoiceIoStats stats() const override
+    {
+        // 成功的发送不产生完成事件: 已发送 = 提交的SQE - 以错误完成的SQE
+        VoiceIoStats stats = VoiceTransport::stats();
+        stats.packetsSent = m_sendsSubmitted - m_sendsFailed;
+
+        // 接收缓冲区由内核从 provided buffer ring 中取用，对应的完成事件被处理后才归还;
+        // 尚未处理的完成事件 (几乎都是接收) 即为占用中的缓冲区
+        stats.poolCapacity = int(RECV_BUFFERS);
+        stats.poolInUse = int(io_uring_cq_ready(&m_ring));
+        stats.poolHighWater = qMax(m_buffersHighWater, stats.poolInUse);
+        stats.poolExhausted = m_buffersExhausted;
+        return stats;
+    }
+
+private:
+    bool setupRing()
+    {
+        int ret = io_uring_queue_init(RING_ENTRIES, &m_ring, 0);
+        if (ret < 0) {
+            m_error = "io_uring_queue_init: " + errnoString(-ret);
+            return false;
+        }
+        m_ringReady = true;
+
+        m_bufRing = io_uring_setup_buf_ring(&m_ring, RECV_BUFFERS, BUFFER_GROUP, 0, &ret);
+        if (!m_bufRing) {
+            m_error = "io_uring_setup_buf_ring: " + errnoString(-ret);
+            return false;
+        }
+
+        if (!m_buffers) {
+            m_buffers.reset(new char[size_t(RECV_BUFFERS) * RECV_BUFFER_SIZE]);
+        }
+        const int mask = io_uring_buf_ring_mask(RECV_BUFFERS);
+        for (unsigned i = 0; i < RECV_BUFFERS; ++i) {
+            io_uring_buf_ring_add(m_bufRing, buffer(i), RECV_BUFFER_SIZE, i, mask, int(i));
+        }
+        io_uring_buf_ring_advance(m_bufRing, int(RECV_BUFFERS));
+
+        m_eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_eventFd < 0) {
+            m_error = "eventfd: " + errnoString(errno);
+            return false;
+        }
+        ret = io_uring_register_eventfd(&m_ring, m_eventFd);
+        if (ret < 0) {
+            m_error = "io_uring_register_eventfd: " + errnoString(-ret);
+            return false;
+        }
+
+        m_recvMsg = {};
+        m_recvMsg.msg_namelen = sizeof(sockaddr_in6);
+        return true;
+    }
+
+    char *buffer(unsigned id) { return m_buffers.get() + size_t(id) * RECV_BUFFER_SIZE; }
+
+    void armReceive()
+    {
+        io_uring_sqe *sqe = io_uring_get_sqe(&m_ring);
+        if (!sqe) {
+            io_uring_submit(&m_ring);
+            sqe = io_uring_get_sqe(&m_ring);
+        }
+        io_uring_prep_recvmsg_multishot(sqe, m_fd, &m_recvMsg, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        io_uring_sqe_set_data64(sqe, RECV_TAG);
+    }
+
+    void onCompletion()
+    {
+        eventfd_t value;
+        ::eventfd_read(m_eventFd, &value);
+        m_stats.receiveCalls++;
+
+        const int mask = io_uring_buf_ring_mask(RECV_BUFFERS);
+        bool rearm = false;
+        int recycled = 0;
+        unsigned seen = 0;
+        unsigned head;
+        io_uring_cqe *cqe;
+
+        io_uring_for_each_cqe(&m_ring, head, cqe) {
+            seen++;
+            // 只有失败的发送会产生完成事件，按UDP语义不重试，只计入统计
+            if (io_uring_cqe_get_data64(cqe) == SEND_TAG) {
+                m_sendsFailed++;
+                continue;
+            }
+
+            // 多发请求被内核终止 (例如缓冲区耗尽) 后需要重新提交
+            if (!(cqe->flags & IORING_CQE_F_MORE)) rearm = true;
+
+            if (cqe->res < 0) {
+                if (cqe->res == -ENOBUFS) m_buffersExhausted++;
+                continue;
+            }
+            if (!(cqe->flags & IORING_CQE_F_BUFFER)) continue;
+
+            unsigned id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            handleDatagram(buffer(id), cqe->res);
+            io_uring_buf_ring_add(m_bufRing, buffer(id), RECV_BUFFER_SIZE, id, mask, recycled++);
+        }
+
+        io_uring_cq_advance(&m_ring, seen);
+        if (recycled > 0) io_uring_buf_ring_advance(m_bufRing, recycled);
+        // 本轮处理前这些缓冲区同时被内核填充的数据包占用
+        m_buffersHighWater = qMax(m_buffersHighWater, recycled);
+
+        if (rearm && m_fd >= 0) {
+            armReceive();
+            io_uring_submit(&m_ring);
+            m_stats.receiveCalls++;
+        }
+    }
+
+    void handleDatagram(char *data, int length)
+    {
+        io_uring_recvmsg_out *out = io_uring_recvmsg_validate(data, length, &m_recvMsg);
+        if (!out || (out->flags & MSG_TRUNC) || out->namelen < sizeof(sockaddr_in6)) return;
+        m_stats.packetsReceived++;
+        if (!m_receiveHandler) return;
+
+        const sockaddr_in6 *addr = static_cast<const sockaddr_in6 *>(io_uring_recvmsg_name(out));
+        VoiceEndpoint from;
+        std::memcpy(from.address.c, addr->sin6_addr.s6_addr, sizeof(from.address.c));
+        from.port = ntohs(addr->sin6_port);
+
+        const char *payload = static_cast<const char *>(io_uring_recvmsg_payload(out, &m_recvMsg));
+        unsigned size = io_uring_recvmsg_payload_length(out, length, &m_recvMsg);
+        m_receiveHandler(from, payload, qsizetype(size));
+    }
+
+    int m_fd = -1;
+    int m_eventFd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QString m_error;
+
+    io_uring m_ring = {};
+    bool m_ringReady = false;
+    io_uring_buf_ring *m_bufRing = nullptr;
+    std::unique_ptr<char[]> m_buffers;
+    msghdr m_recvMsg = {};
+    quint64 m_buffersExhausted = 0;
+    int m_buffersHighWater = 0;
+    quint64 m_sendsSubmitted = 0;
+    quint64 m_sendsFailed = 0;
+
+    msghdr m_txMsgs[RING_ENTRIES] = {};
+};
+
+} // namespace
+
+VoiceTransport *createUringVoiceTransport(QObject *parent, QString *reason)
+{
+    static QString probeError;
+    static const bool supported = probeUring(&probeError);
+    if (!supported) {
+        if (reason) *reason = probeError;
+        return nullptr;
+    }
+    return new UringVoiceTransport(parent);
+}
@@ -0,0 +1,16 @@
+#ifndef URINGVOICETRANSPORT_H
+#define URINGVOICETRANSPORT_H
+
+#include "voicetransport.h"
+
+// 仅在以 VOICEPHONE_IO_URING 构建时可用 (Linux + liburing)
+
+/**
+ * @brief 创建io_uring语音后端
+ *
+ * 首次调用时探测内核是否支持 (io_uring、provided buffer ring、多发recvmsg)，
+ * 结果会被缓存。不支持时返回nullptr并在 reason 中说明原因，由调用者回退到其他后端。
+ */
+VoiceTransport *createUringVoiceTransport(QObject *parent, QString *reason);
+
+#endif // URINGVOICETRANSPORT_H
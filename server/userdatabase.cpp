@@ -22,10 +22,7 @@ bool UserDatabase::initialize(const QString &dbPath)
 {
     // 创建SQLite数据库连接
     m_database = QSqlDatabase::addDatabase("QSQLITE");
-    m_database.setDatabaseName(dbPath);
-    
-    if (!m_database.open()) {
-        qCritical() << "Failed to open database:" << m_database.lastError().text();
+    if (!openDatabase(m_database, dbPath)) {
         return false;
     }
     
@@ -58,6 +55,22 @@ bool UserDatabase::initialize(const QString &dbPath)
     return true;
 }
 
+bool UserDatabase::openDatabase(QSqlDatabase &database, const QString &dbPath)
+{
+    database.setDatabaseName(dbPath);
+    // 集群中多个进程 (以及认证线程池中的多个连接) 共享同一数据库文件，写入冲突时等待而不是立即失败
+    database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    
+    if (!database.open()) {
+        qCritical() << "Failed to open database:" << database.lastError().text();
+        return false;
+    }
+    
+    // WAL模式下读取不会被其他连接的写入阻塞
+    QSqlQuery(database).exec("PRAGMA journal_mode=WAL");
+    return true;
+}
+
 bool UserDatabase::createTables()
 {
     QSqlQuery query(m_database);
@@ -110,9 +123,54 @@ bool UserDatabase::loadUsersFromDatabase()
     return true;
 }
 
-bool UserDatabase::saveUserToDatabase(const UserCredentials &user)
+void UserDatabase::reloadUser(const QString &username)
 {
-    QSqlQuery query(m_database);
+    UserCredentials cred;
+    if (loadUser(m_database, username, &cred)) {
+        m_users[username] = cred;
+    } else {
+        m_users.remove(username);
+    }
+}
+
+void UserDatabase::cacheUser(const UserCredentials &user)
+{
+    m_users[user.username] = user;
+}
+
+bool UserDatabase::loadUser(QSqlDatabase &database, const QString &username, UserCredentials *user)
+{
+    QSqlQuery query(database);
+    query.prepare("SELECT password_hash, user_type, created_at FROM users WHERE username = :username");
+    query.bindValue(":username", username);
+    if (!query.exec()) {
+        qWarning() << "Failed to reload user:" << query.lastError().text();
+        return false;
+    }
+    
+    if (!query.next()) {
+        return false;
+    }
+    
+    user->username = username;
+    user->passwordHash = QByteArray::fromHex(query.value(0).toByteArray());
+    user->userType = static_cast<UserType>(query.value(1).toInt());
+    user->createdAt = query.value(2).toString();
+    return true;
+}
+
+void UserDatabase::updateLastLogin(QSqlDatabase &database, const QString &username)
+{
+    QSqlQuery query(database);
+    query.prepare("UPDATE users SET last_login = :last_login WHERE username = :username");
+    query.bindValue(":last_login", QDateTime::currentDateTime().toString(Qt::ISODate));
+    query.bindValue(":username", username);
+    query.exec();
+}
+
+bool UserDatabase::insertUser(QSqlDatabase &database, const UserCredentials &user)
+{
+    QSqlQuery query(database);
     
     query.prepare("INSERT INTO users (username, password_hash, user_type, created_at) "
                   "VALUES (:username, :password_hash, :user_type, :created_at)");
@@ -148,7 +206,7 @@ bool UserDatabase::registerUser(const QString &username, const QByteArray &passw
     cred.createdAt = QDateTime::currentDateTime().toString(Qt::ISODate);
     
     // 保存到数据库
-    if (!saveUserToDatabase(cred)) {
+    if (!insertUser(m_database, cred)) {
         return false;
     }
     
@@ -163,6 +221,9 @@ bool UserDatabase::registerUser(const QString &username, const QByteArray &passw
 
 bool UserDatabase::authenticate(const QString &username, const QByteArray &passwordHash)
 {
+    // 用户可能由集群中的其他节点注册或修改，登录时以数据库为准刷新缓存
+    reloadUser(username);
+    
     if (!m_users.contains(username)) {
         qWarning() << "User not found:" << username;
         return false;
@@ -173,11 +234,7 @@ bool UserDatabase::authenticate(const QString &username, const QByteArray &passw
     
     if (valid) {
         // 更新最后登录时间
-        QSqlQuery query(m_database);
-        query.prepare("UPDATE users SET last_login = :last_login WHERE username = :username");
-        query.bindValue(":last_login", QDateTime::currentDateTime().toString(Qt::ISODate));
-        query.bindValue(":username", username);
-        query.exec();
+        updateLastLogin(m_database, username);
         
         QString userTypeStr = (cred.userType == UserType::Administrator) ? "Admin" : "User";
         qInfo() << "Authentication successful for:" << username << "(" << userTypeStr << ")";
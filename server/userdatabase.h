@@ -58,10 +58,19 @@ public:
     void setSessionKey(const QString &sessionId, const QByteArray &key);
     QByteArray getSessionKey(const QString &sessionId) const;
 
+    // 用异步认证 (AuthService) 从数据库读取的用户记录更新缓存
+    void cacheUser(const UserCredentials &user);
+
+    // 以下只操作传入的连接，不访问缓存，可在持有该连接的任意线程调用
+    static bool openDatabase(QSqlDatabase &database, const QString &dbPath);
+    static bool loadUser(QSqlDatabase &database, const QString &username, UserCredentials *user);
+    static bool insertUser(QSqlDatabase &database, const UserCredentials &user);
+    static void updateLastLogin(QSqlDatabase &database, const QString &username);
+
 private:
     bool createTables();
     bool loadUsersFromDatabase();
-    bool saveUserToDatabase(const UserCredentials &user);
+    void reloadUser(const QString &username);
     
     QSqlDatabase m_database;
     QMap<QString, UserCredentials> m_users; // username -> credentials (缓存)
@@ -0,0 +1,31 @@
+#include "voicebufferpool.h"
+
+VoiceBufferPool::VoiceBufferPool(int capacity)
+    : m_storage(new char[size_t(capacity) * BUFFER_SIZE])
+{
+    m_free.reserve(capacity);
+    for (int i = capacity - 1; i >= 0; --i) {
+        m_free.append(m_storage.get() + size_t(i) * BUFFER_SIZE);
+    }
+    m_stats.capacity = capacity;
+}
+
+char *VoiceBufferPool::acquire()
+{
+    if (m_free.isEmpty()) {
+        m_stats.exhausted++;
+        return nullptr;
+    }
+
+    m_stats.acquired++;
+    m_stats.inUse++;
+    m_stats.highWater = qMax(m_stats.highWater, m_stats.inUse);
+    return m_free.takeLast();
+}
+
+void VoiceBufferPool::release(char *buffer)
+{
+    if (!buffer) return;
+    m_free.append(buffer);
+    m_stats.inUse--;
+}
@@ -0,0 +1,42 @@
+#ifndef VOICEBUFFERPOOL_H
+#define VOICEBUFFERPOOL_H
+
+#include <QVector>
+#include <memory>
+
+/**
+ * @brief 固定大小的语音数据包缓冲池
+ *
+ * 启动时一次性分配全部缓冲区，之后接收路径直接读入池中的缓冲区，
+ * 并从同一缓冲区转发，每个数据包不再有堆分配和复制。
+ * 只在所属转发线程内使用，无需加锁。
+ */
+class VoiceBufferPool
+{
+public:
+    // 足以容纳最大的Opus数据包 (1275字节) 加上数据包头部，并与以太网MTU对齐
+    static constexpr int BUFFER_SIZE = 1500;
+
+    struct Stats {
+        int capacity = 0;
+        int inUse = 0;
+        int highWater = 0;      // 同时占用的最大缓冲区数
+        quint64 acquired = 0;
+        quint64 exhausted = 0;  // 池耗尽导致的获取失败次数
+    };
+
+    explicit VoiceBufferPool(int capacity);
+
+    // 池耗尽时返回nullptr
+    char *acquire();
+    void release(char *buffer);
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    std::unique_ptr<char[]> m_storage;
+    QVector<char*> m_free;
+    Stats m_stats;
+};
+
+#endif // VOICEBUFFERPOOL_H
@@ -0,0 +1,68 @@
+#ifndef VOICEENDPOINT_H
+#define VOICEENDPOINT_H
+
+#include <QHostAddress>
+#include <QHashFunctions>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <netinet/in.h>
+#endif
+
+// UDP语音端点 (地址 + 端口)
+// 地址统一保存为16字节IPv6形式 (IPv4使用 ::ffff:a.b.c.d 映射)，
+// 因此可以不分配内存地进行比较和哈希，用作发送者索引的键
+struct VoiceEndpoint {
+    Q_IPV6ADDR address = {};
+    quint16 port = 0;
+
+    static VoiceEndpoint fromAddress(const QHostAddress &address, quint16 port)
+    {
+        VoiceEndpoint endpoint;
+        endpoint.address = address.toIPv6Address();
+        endpoint.port = port;
+        return endpoint;
+    }
+
+    QHostAddress toAddress() const { return QHostAddress(address); }
+    bool isValid() const { return port != 0; }
+};
+
+inline bool operator==(const VoiceEndpoint &a, const VoiceEndpoint &b)
+{
+    return a.port == b.port && std::memcmp(a.address.c, b.address.c, sizeof(a.address.c)) == 0;
+}
+
+inline bool operator!=(const VoiceEndpoint &a, const VoiceEndpoint &b)
+{
+    return !(a == b);
+}
+
+inline size_t qHash(const VoiceEndpoint &key, size_t seed = 0)
+{
+    return qHashMulti(seed, qHashBits(key.address.c, sizeof(key.address.c)), key.port);
+}
+
+// 预先转换好的转发目标，只在成员变化时构建，每个数据包直接使用
+struct VoiceDestination {
+#ifdef Q_OS_LINUX
+    sockaddr_in6 sockAddress = {}; // 批量后端直接作为 msg_name 使用
+#endif
+    QHostAddress address;          // QUdpSocket后端使用
+    quint16 port = 0;
+
+    static VoiceDestination fromEndpoint(const VoiceEndpoint &endpoint)
+    {
+        VoiceDestination destination;
+#ifdef Q_OS_LINUX
+        destination.sockAddress.sin6_family = AF_INET6;
+        destination.sockAddress.sin6_port = htons(endpoint.port);
+        std::memcpy(destination.sockAddress.sin6_addr.s6_addr, endpoint.address.c, sizeof(endpoint.address.c));
+#endif
+        destination.address = endpoint.toAddress();
+        destination.port = endpoint.port;
+        return destination;
+    }
+};
+
+#endif // VOICEENDPOINT_H
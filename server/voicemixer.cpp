@@ -0,0 +1,297 @@
+#include "voicemixer.h"
+#include "voiceplane.h"
+#include "../src/opuscodec.h"
+#include "../src/pcmmix.h"
+#include "../src/voicepacket.h"
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QDebug>
+#include <cstring>
+
+static constexpr int MIX_INTERVAL_MS = 20;
+static constexpr int FRAME_SIZE = 960;        // 20ms @ 48kHz
+static constexpr int SAMPLE_RATE = 48000;
+static constexpr int CHANNELS = 1;
+static constexpr int BITRATE = 24000;
+static constexpr int SPEAKER_IDLE_TICKS = 50; // 1秒无音频后释放发言者的编解码器
+static constexpr int STREAM_IDLE_TICKS = 500; // 10秒未发送后释放发言者混音流的状态
+
+static OpusCodec *createCodec()
+{
+    OpusCodec *codec = new OpusCodec();
+    if (!codec->initialize(SAMPLE_RATE, CHANNELS, BITRATE)) {
+        qWarning() << "Failed to initialize mixer codec:" << codec->lastError();
+    }
+    return codec;
+}
+
+VoiceMixChannel::VoiceMixChannel(const QByteArray &channelKey, quint16 sharedStreamId)
+    : m_sharedCodec(createCodec())
+    , m_mix(FRAME_SIZE * CHANNELS)
+    , m_ownMix(FRAME_SIZE * CHANNELS)
+    , m_timestamp(QRandomGenerator::global()->generate())
+{
+    m_sharedStream.senderId = sharedStreamId;
+    m_sharedStream.sequence = QRandomGenerator::global()->generate();
+    if (!channelKey.isEmpty()) {
+        m_cipher.setKey(channelKey);
+    }
+}
+
+VoiceMixChannel::~VoiceMixChannel()
+{
+    qDeleteAll(m_pending);
+    for (Speaker *speaker : std::as_const(m_speakers)) {
+        delete speaker->codec;
+        delete speaker;
+    }
+    delete m_sharedCodec;
+}
+
+void VoiceMixChannel::ingest(const VoiceEndpoint &from, const char *data, qsizetype size)
+{
+    if (size <= 0 || size > VoiceBufferPool::BUFFER_SIZE) return;
+
+    QMutexLocker locker(&m_pendingLock);
+    PacketQueue *&queue = m_pending[from];
+    if (!queue) {
+        queue = new PacketQueue;
+    }
+    if (queue->count == PacketQueue::CAPACITY) {
+        queue->head = (queue->head + 1) % PacketQueue::CAPACITY;
+        queue->count--;
+    }
+
+    Packet &packet = queue->packets[(queue->head + queue->count) % PacketQueue::CAPACITY];
+    std::memcpy(packet.data, data, size_t(size));
+    packet.size = size;
+    queue->count++;
+}
+
+VoiceMixChannel::Speaker *VoiceMixChannel::speaker(const VoiceEndpoint &endpoint)
+{
+    Speaker *&speaker = m_speakers[endpoint];
+    if (!speaker) {
+        speaker = new Speaker;
+        speaker->codec = createCodec();
+        speaker->pcm.resize(FRAME_SIZE * CHANNELS);
+    }
+    return speaker;
+}
+
+VoiceMixChannel::OutputStream *VoiceMixChannel::speakerStream(quint16 senderId)
+{
+    auto it = m_speakerStreams.find(senderId);
+    if (it == m_speakerStreams.end()) {
+        OutputStream stream;
+        stream.senderId = senderId;
+        stream.sequence = QRandomGenerator::global()->generate();
+        it = m_speakerStreams.insert(senderId, stream);
+    }
+    return &it.value();
+}
+
+bool VoiceMixChannel::decodePacket(Speaker *speaker)
+{
+    Packet &packet = speaker->packet;
+    VoicePacket::Header header;
+    if (packet.size <= VoicePacket::HEADER_SIZE || !VoicePacket::readHeader(packet.data, packet.size, &header)) {
+        return false;
+    }
+
+    // 槽位属于该发言者，直接原地校验并解密；认证失败的数据包不解码
+    char *payload = packet.data + VoicePacket::HEADER_SIZE;
+    qsizetype payloadSize = packet.size - VoicePacket::HEADER_SIZE;
+    if (m_cipher.isValid()) {
+        payloadSize -= VoicePacket::TAG_SIZE;
+        if (payloadSize <= 0
+            || !m_cipher.openGCM(payload, payloadSize, QByteArrayView(packet.data, VoicePacket::HEADER_SIZE),
+                                 VoicePacket::nonce(header), payload + payloadSize)) {
+            return false;
+        }
+    }
+    QByteArray opus = QByteArray::fromRawData(payload, payloadSize);
+
+    QByteArray decoded = speaker->codec->decode(opus, FRAME_SIZE);
+    if (decoded.isEmpty()) return false;
+
+    // 解码结果不足一帧时补零
+    PcmMix::clear(speaker->pcm.data(), speaker->pcm.size());
+    std::memcpy(speaker->pcm.data(), decoded.constData(),
+                qMin<size_t>(size_t(decoded.size()), size_t(speaker->pcm.size()) * sizeof(qint16)));
+    return true;
+}
+
+QByteArray VoiceMixChannel::encodePacket(OpusCodec *codec, const qint16 *pcm, OutputStream *stream)
+{
+    QByteArray frame(reinterpret_cast<const char *>(pcm), FRAME_SIZE * CHANNELS * int(sizeof(qint16)));
+    QByteArray payload = codec->encode(frame, FRAME_SIZE);
+    if (payload.isEmpty()) return QByteArray();
+
+    // 每一路输出使用自己的发送者ID和连续的序号；上一周期没有发送时标记新的一段发言，
+    // 接收端据此知道中间的间隔是服务器有意停发而不是丢包
+    VoicePacket::Header header;
+    header.flags = VoicePacket::FLAG_MIXED;
+    if (!stream->started || stream->lastTick + 1 != m_tick) {
+        header.flags |= VoicePacket::FLAG_MARKER;
+    }
+    header.level = VoicePacket::audioLevel(pcm, FRAME_SIZE * CHANNELS);
+    header.senderId = stream->senderId;
+    header.sequence = stream->sequence;
+    header.timestamp = m_timestamp;
+
+    // 头部、密文和认证标签写入同一个缓冲区，Opus数据原地加密
+    const bool encrypted = m_cipher.isValid();
+    QByteArray packet(VoicePacket::HEADER_SIZE + payload.size() + (encrypted ? VoicePacket::TAG_SIZE : 0),
+                      Qt::Uninitialized);
+    VoicePacket::writeHeader(packet.data(), header);
+    char *body = packet.data() + VoicePacket::HEADER_SIZE;
+    std::memcpy(body, payload.constData(), size_t(payload.size()));
+    if (encrypted
+        && !m_cipher.sealGCM(body, payload.size(), QByteArrayView(packet.constData(), VoicePacket::HEADER_SIZE),
+                             VoicePacket::nonce(header), body + payload.size())) {
+        return QByteArray();
+    }
+
+    stream->sequence++;
+    stream->lastTick = m_tick;
+    stream->started = true;
+    return packet;
+}
+
+void VoiceMixChannel::mix(const VoiceChannelRoute &route, VoiceTransport *transport)
+{
+    m_tick++;
+    for (Speaker *speaker : std::as_const(m_speakers)) {
+        speaker->active = false;
+        speaker->packet.size = 0;
+    }
+
+    // 每个发言者取出一帧，复制到发言者自己的槽位后即可释放锁
+    {
+        QMutexLocker locker(&m_pendingLock);
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            PacketQueue *queue = it.value();
+            if (queue->count == 0) {
+                // 发言者已被释放时才回收队列，持续发言者的队列一直复用
+                if (!m_speakers.contains(it.key())) {
+                    delete queue;
+                    it = m_pending.erase(it);
+                } else {
+                    ++it;
+                }
+                continue;
+            }
+            const Packet &packet = queue->packets[queue->head];
+            Packet &slot = speaker(it.key())->packet;
+            std::memcpy(slot.data, packet.data, size_t(packet.size));
+            slot.size = packet.size;
+            queue->head = (queue->head + 1) % PacketQueue::CAPACITY;
+            queue->count--;
+            ++it;
+        }
+    }
+
+    int activeCount = 0;
+    for (Speaker *s : std::as_const(m_speakers)) {
+        if (s->packet.size > 0 && decodePacket(s)) {
+            s->active = true;
+            s->idleTicks = 0;
+            activeCount++;
+        }
+    }
+
+    // 释放长时间不发言的发言者
+    for (auto it = m_speakers.begin(); it != m_speakers.end();) {
+        Speaker *s = it.value();
+        if (!s->active && ++s->idleTicks > SPEAKER_IDLE_TICKS) {
+            delete s->codec;
+            delete s;
+            it = m_speakers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_speakerStreams.begin(); it != m_speakerStreams.end();) {
+        if (m_tick - it->lastTick > STREAM_IDLE_TICKS) {
+            it = m_speakerStreams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // 时间戳每个混音周期前进一帧 (包括静音周期)，同一周期的所有输出共享时间戳
+    m_timestamp += FRAME_SIZE;
+    if (activeCount == 0) return;
+
+    PcmMix::clear(m_mix.data(), m_mix.size());
+    for (Speaker *s : std::as_const(m_speakers)) {
+        if (s->active) {
+            PcmMix::addSaturate(m_mix.data(), s->pcm.constData(), m_mix.size());
+        }
+    }
+
+    // 发言者单独编码 (不含自己的声音)，其余听众共享完整混音
+    m_listeners.clear();
+    for (int slot = 0; slot < route.endpoints.size(); ++slot) {
+        Speaker *self = m_speakers.value(route.endpoints.at(slot));
+        if (!self || !self->active) {
+            m_listeners.append(route.destinations.at(slot));
+            continue;
+        }
+        if (activeCount == 1) continue; // 只有自己在说话
+        const quint16 streamId = route.mixStreamIds.at(slot);
+        if (streamId == 0) continue;     // 服务器没有可分配的ID
+
+        PcmMix::clear(m_ownMix.data(), m_ownMix.size());
+        for (Speaker *other : std::as_const(m_speakers)) {
+            if (other != self && other->active) {
+                PcmMix::addSaturate(m_ownMix.data(), other->pcm.constData(), m_ownMix.size());
+            }
+        }
+
+        QByteArray packet = encodePacket(self->codec, m_ownMix.constData(), speakerStream(streamId));
+        if (!packet.isEmpty()) {
+            transport->send(packet.constData(), packet.size(), &route.destinations.at(slot), 1);
+        }
+    }
+
+    if (!m_listeners.isEmpty()) {
+        QByteArray packet = encodePacket(m_sharedCodec, m_mix.constData(), &m_sharedStream);
+        if (!packet.isEmpty()) {
+            transport->send(packet.constData(), packet.size(), m_listeners.constData(), m_listeners.size());
+        }
+    }
+}
+
+VoiceMixer::VoiceMixer(VoicePlane *plane, VoiceTransport *transport)
+    : m_plane(plane)
+    , m_transport(transport)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, [this]() { tick(); });
+}
+
+void VoiceMixer::start()
+{
+    m_timer->start(MIX_INTERVAL_MS);
+}
+
+void VoiceMixer::stop()
+{
+    m_timer->stop();
+}
+
+void VoiceMixer::tick()
+{
+    m_plane->loadRoutes(m_routes, m_routesGeneration);
+    if (!m_routes || !m_transport) return;
+
+    for (const VoiceChannelRoutePtr &route : m_routes->channels) {
+        if (route->mix) {
+            route->mix->mix(*route, m_transport);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef VOICEMIXER_H
+#define VOICEMIXER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <memory>
+#include "../src/crypto.h"
+#include "voicebufferpool.h"
+#include "voiceendpoint.h"
+
+class OpusCodec;
+class QTimer;
+class VoicePlane;
+class VoiceTransport;
+struct VoiceChannelRoute;
+struct VoiceRoutes;
+
+/**
+ * @brief 混音模式频道的状态 (MCU)
+ *
+ * 转发线程把发言者的数据包交给 ingest()，混音器每20ms调用一次 mix():
+ * 解密并解码每个发言者的一帧，饱和相加后为每个听众重新编码一路音频。
+ * 发言者收到的混音中不包含自己的声音；非发言的听众共享同一路编码结果。
+ * 输出使用频道密钥加密，客户端无需任何改动即可播放。
+ *
+ * 每一路编码输出 (每个发言者各自的混音和听众共享的混音) 使用服务器单独分配的发送者ID，
+ * 序号和时间戳各自连续，接收端按发送者ID区分编码器状态，GCM的nonce也互不重叠。
+ */
+class VoiceMixChannel
+{
+public:
+    VoiceMixChannel(const QByteArray &channelKey, quint16 sharedStreamId);
+    ~VoiceMixChannel();
+
+    quint16 sharedStreamId() const { return m_sharedStream.senderId; }
+
+    // 可在任意转发线程调用
+    void ingest(const VoiceEndpoint &from, const char *data, qsizetype size);
+
+    // 仅在混音器线程调用
+    void mix(const VoiceChannelRoute &route, VoiceTransport *transport);
+
+private:
+    // 预分配的数据包槽位，ingest 只做一次定长复制，不分配内存
+    struct Packet {
+        char data[VoiceBufferPool::BUFFER_SIZE];
+        qsizetype size = 0;
+    };
+
+    // 每个发言者的待混音环形队列，首次发言时分配一次
+    struct PacketQueue {
+        static constexpr int CAPACITY = 4; // 超出时丢弃最旧的
+        Packet packets[CAPACITY];
+        int head = 0;
+        int count = 0;
+    };
+
+    struct Speaker {
+        OpusCodec *codec = nullptr;  // 解码该发言者的音频，并编码发给他的混音
+        Packet packet;               // 本周期取出的数据包
+        QVector<qint16> pcm;         // 本周期解码出的一帧
+        bool active = false;         // 本周期是否有音频
+        int idleTicks = 0;
+    };
+
+    // 一路编码输出；序号只在实际发送时前进，中断后的第一个包带发言开始标记
+    struct OutputStream {
+        quint16 senderId = 0;
+        quint32 sequence = 0;
+        quint64 lastTick = 0; // 最近一次发送的混音周期
+        bool started = false;
+    };
+
+    Speaker *speaker(const VoiceEndpoint &endpoint);
+    OutputStream *speakerStream(quint16 senderId);
+    bool decodePacket(Speaker *speaker);
+    QByteArray encodePacket(OpusCodec *codec, const qint16 *pcm, OutputStream *stream);
+
+    // 由 ingest 和 mix 共享，受锁保护
+    QMutex m_pendingLock;
+    QHash<VoiceEndpoint, PacketQueue*> m_pending;
+
+    // 以下仅在混音器线程访问
+    AesContext m_cipher;          // 频道密钥，解密输入和加密输出共用
+    QHash<VoiceEndpoint, Speaker*> m_speakers;
+    QHash<quint16, OutputStream> m_speakerStreams; // 发给各发言者的混音，以该成员的混音流ID为键
+    OpusCodec *m_sharedCodec;     // 非发言听众共享的编码器
+    OutputStream m_sharedStream;
+    QVector<qint16> m_mix;        // 所有发言者的混音
+    QVector<qint16> m_ownMix;     // 去掉某个发言者后的混音
+    QVector<VoiceDestination> m_listeners;
+    quint64 m_tick = 0;
+    quint32 m_timestamp;  // 所有输出共用的媒体时间戳，每个混音周期前进一帧，起始值随机
+};
+
+/**
+ * @brief 混音器: 每20ms为路由快照中的所有混音频道生成一帧
+ *
+ * 运行在第一个转发器所在的线程，并使用它的语音套接字发送，
+ * 因此混音输出与转发数据包共用同一个源端口。
+ */
+class VoiceMixer : public QObject
+{
+public:
+    VoiceMixer(VoicePlane *plane, VoiceTransport *transport);
+
+    void start();
+    void stop();
+
+private:
+    void tick();
+
+    VoicePlane *m_plane;
+    VoiceTransport *m_transport;
+    QTimer *m_timer;
+    std::shared_ptr<const VoiceRoutes> m_routes;
+    quint64 m_routesGeneration = 0;
+};
+
+#endif // VOICEMIXER_H
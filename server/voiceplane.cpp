@@ -0,0 +1,245 @@
+#include "voiceplane.h"
+#include "voicemixer.h"
+#include "speakerselector.h"
+#include "../src/voicepacket.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+
+// 单个转发器: 拥有一个语音套接字，在所属线程内完成 接收 -> 查找发送者 -> 转发
+class VoiceRelay : public QObject
+{
+public:
+    explicit VoiceRelay(VoicePlane *plane)
+        : m_plane(plane)
+    {
+    }
+
+    bool bind(quint16 port, VoiceIoBackend backend, bool reusePort)
+    {
+        m_transport = VoiceTransport::create(backend, this);
+        m_transport->setReceiveHandler([this](const VoiceEndpoint &from, const char *data, qsizetype size) {
+            onDatagram(from, data, size);
+        });
+        if (!m_transport->bind(port, reusePort)) {
+            m_error = m_transport->errorString();
+            delete m_transport;
+            m_transport = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (m_transport) {
+            m_transport->close();
+        }
+    }
+
+    QString errorString() const { return m_error; }
+    const char *name() const { return m_transport ? m_transport->name() : "none"; }
+    VoiceIoStats stats() const { return m_transport ? m_transport->stats() : VoiceIoStats(); }
+    VoiceTransport *transport() const { return m_transport; }
+
+private:
+    void onDatagram(const VoiceEndpoint &from, const char *data, qsizetype size)
+    {
+        m_plane->loadRoutes(m_routes, m_routesGeneration);
+        if (!m_routes) return;
+
+        auto sender = m_routes->senders.constFind(from);
+        if (sender == m_routes->senders.constEnd()) return;
+
+        // 头部版本不符或发送者ID与登录时分配的不一致时丢弃，接收方可以信任头部中的发送者ID
+        if (!VoicePacket::isValid(data, size) || VoicePacket::readSenderId(data) != sender->voiceId) return;
+
+        const VoiceChannelRoute &route = *m_routes->channels.at(sender->channel);
+        if (route.mix) {
+            route.mix->ingest(from, data, size);
+            return;
+        }
+
+        // 根据明文头部的音频电平，只转发当前最响的N个发言者
+        if (route.speakerSelector) {
+            if (!route.speakerSelector->admit(from, VoicePacket::readLevel(data))) return;
+        }
+
+        // 直接转发音频数据（客户端之间端到端加密）
+        m_transport->send(data, size, route.destinations.constData(), route.destinations.size(), sender->slot);
+    }
+
+    VoicePlane *m_plane;
+    VoiceTransport *m_transport = nullptr;
+    QString m_error;
+    VoiceRoutesPtr m_routes;
+    quint64 m_routesGeneration = 0;
+};
+
+VoicePlane::VoicePlane(QObject *parent)
+    : QObject(parent)
+{
+}
+
+VoicePlane::~VoicePlane()
+{
+    stop();
+}
+
+bool VoicePlane::start(quint16 port, int threads, VoiceIoBackend backend)
+{
+    stop();
+    m_error.clear();
+
+#ifndef Q_OS_LINUX
+    if (threads > 0) {
+        qWarning() << "Voice forwarding threads require SO_REUSEPORT (Linux), forwarding on the main thread";
+        threads = 0;
+    }
+#endif
+
+    // 线程数为0: 在当前线程上运行单个转发器
+    if (threads <= 0) {
+        VoiceRelay *relay = new VoiceRelay(this);
+        if (!relay->bind(port, backend, false)) {
+            m_error = relay->errorString();
+            delete relay;
+            return false;
+        }
+        m_relays.append(relay);
+        startMixer();
+        return true;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        QThread *thread = new QThread;
+        thread->setObjectName(QString("voice-relay-%1").arg(i));
+        VoiceRelay *relay = new VoiceRelay(this);
+        relay->moveToThread(thread);
+        connect(thread, &QThread::finished, relay, &QObject::deleteLater);
+        thread->start(QThread::HighPriority);
+
+        // 套接字及其通知器必须在工作线程内创建
+        bool ok = false;
+        QMetaObject::invokeMethod(relay, [relay, port, backend, &ok]() {
+            ok = relay->bind(port, backend, true);
+        }, Qt::BlockingQueuedConnection);
+
+        m_relays.append(relay);
+        m_threads.append(thread);
+
+        if (!ok) {
+            QMetaObject::invokeMethod(relay, [this, relay]() {
+                m_error = relay->errorString();
+            }, Qt::BlockingQueuedConnection);
+            stop();
+            return false;
+        }
+    }
+
+    startMixer();
+    qInfo() << "Voice forwarding plane started with" << threads << "threads";
+    return true;
+}
+
+void VoicePlane::startMixer()
+{
+    // 混音器与第一个转发器在同一线程，使用它的套接字发送
+    VoiceRelay *relay = m_relays.first();
+    m_mixer = new VoiceMixer(this, relay->transport());
+    if (m_threads.isEmpty()) {
+        m_mixer->start();
+        return;
+    }
+
+    m_mixer->moveToThread(m_threads.first());
+    VoiceMixer *mixer = m_mixer;
+    QMetaObject::invokeMethod(mixer, [mixer]() { mixer->start(); }, Qt::BlockingQueuedConnection);
+}
+
+void VoicePlane::stopMixer()
+{
+    if (!m_mixer) return;
+
+    VoiceMixer *mixer = m_mixer;
+    m_mixer = nullptr;
+    if (m_threads.isEmpty()) {
+        delete mixer;
+        return;
+    }
+
+    QMetaObject::invokeMethod(mixer, [mixer]() {
+        mixer->stop();
+        delete mixer;
+    }, Qt::BlockingQueuedConnection);
+}
+
+void VoicePlane::stop()
+{
+    stopMixer();
+
+    if (m_threads.isEmpty()) {
+        // 单线程模式: 转发器属于当前线程
+        qDeleteAll(m_relays);
+        m_relays.clear();
+        return;
+    }
+
+    for (int i = 0; i < m_threads.size(); ++i) {
+        VoiceRelay *relay = m_relays.at(i);
+        QMetaObject::invokeMethod(relay, [relay]() { relay->close(); }, Qt::BlockingQueuedConnection);
+        m_threads.at(i)->quit();
+        m_threads.at(i)->wait();
+        delete m_threads.at(i);
+    }
+    m_threads.clear();
+    m_relays.clear();
+}
+
+const char *VoicePlane::backendName() const
+{
+    return m_relays.isEmpty() ? "none" : m_relays.first()->name();
+}
+
+void VoicePlane::publishRoutes(VoiceRoutesPtr routes)
+{
+    QMutexLocker locker(&m_routesLock);
+    m_routes = std::move(routes);
+    m_routesGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void VoicePlane::loadRoutes(VoiceRoutesPtr &routes, quint64 &generation) const
+{
+    quint64 current = m_routesGeneration.load(std::memory_order_acquire);
+    if (current == generation) return;
+
+    QMutexLocker locker(&m_routesLock);
+    routes = m_routes;
+    generation = current;
+}
+
+VoiceIoStats VoicePlane::stats() const
+{
+    VoiceIoStats total;
+    for (int i = 0; i < m_relays.size(); ++i) {
+        VoiceRelay *relay = m_relays.at(i);
+        VoiceIoStats stats;
+        if (m_threads.isEmpty()) {
+            stats = relay->stats();
+        } else {
+            // 统计数据只在转发线程内修改，在该线程内读取
+            QMetaObject::invokeMethod(relay, [relay, &stats]() {
+                stats = relay->stats();
+            }, Qt::BlockingQueuedConnection);
+        }
+        total.packetsReceived += stats.packetsReceived;
+        total.receiveCalls += stats.receiveCalls;
+        total.packetsSent += stats.packetsSent;
+        total.sendCalls += stats.sendCalls;
+        total.poolCapacity += stats.poolCapacity;
+        total.poolInUse += stats.poolInUse;
+        total.poolHighWater = qMax(total.poolHighWater, stats.poolHighWater);
+        total.poolExhausted += stats.poolExhausted;
+    }
+    return total;
+}
@@ -0,0 +1,91 @@
+#ifndef VOICEPLANE_H
+#define VOICEPLANE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "voiceendpoint.h"
+#include "voicetransport.h"
+
+class QThread;
+class VoiceMixChannel;
+class VoiceMixer;
+class VoiceRelay;
+class VoiceSpeakerSelector;
+
+// 单个频道的转发表: 连续存放的预构建目标，发送者以下标 (slot) 跳过
+// 只在该频道有成员加入、离开或端点变化时重新构建，未变化的频道在快照之间共享
+struct VoiceChannelRoute {
+    QVector<VoiceDestination> destinations; // 每包遍历的热数据
+    QVector<VoiceEndpoint> endpoints;       // 与 destinations 一一对应，仅用于构建发送者索引
+    QVector<quint16> voiceIds;              // 与 endpoints 一一对应，成员的语音发送者ID
+    QVector<quint16> mixStreamIds;          // 与 endpoints 一一对应，混音模式下该成员发言时收到的混音流的发送者ID
+    std::shared_ptr<VoiceMixChannel> mix;   // 非空时为混音模式，数据包交给混音器而不是直接转发
+    std::shared_ptr<VoiceSpeakerSelector> speakerSelector; // 非空时只转发最响的N个发言者
+};
+
+using VoiceChannelRoutePtr = std::shared_ptr<const VoiceChannelRoute>;
+
+// 语音转发路由快照
+// 由VoiceServer在登录、断开、加入/离开频道时重新构建，发布后只读，可被多个转发线程共享
+struct VoiceRoutes {
+    struct Sender {
+        int channel = -1; // channels 下标
+        int slot = -1;    // 发送者在频道转发表中的下标
+        quint16 voiceId = 0; // 数据包头部必须携带的发送者ID
+    };
+
+    QHash<VoiceEndpoint, Sender> senders;
+    QVector<VoiceChannelRoutePtr> channels;
+};
+
+using VoiceRoutesPtr = std::shared_ptr<const VoiceRoutes>;
+
+/**
+ * @brief 语音转发平面
+ *
+ * 在N个工作线程上运行语音转发，与控制连接所在的事件循环分离。
+ * 每个线程以SO_REUSEPORT绑定同一语音端口，由内核按客户端分流。
+ * 线程数为0时，在调用者线程上运行单个转发器 (原有行为)。
+ */
+class VoicePlane : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VoicePlane(QObject *parent = nullptr);
+    ~VoicePlane();
+
+    bool start(quint16 port, int threads, VoiceIoBackend backend);
+    void stop();
+    bool isRunning() const { return !m_relays.isEmpty(); }
+    QString errorString() const { return m_error; }
+    const char *backendName() const;
+    int threadCount() const { return m_threads.size(); }
+
+    // 发布新的路由快照，转发线程在处理下一个数据包时生效
+    void publishRoutes(VoiceRoutesPtr routes);
+
+    // 仅当快照有更新时才加锁复制指针 (供转发线程和混音器调用)
+    void loadRoutes(VoiceRoutesPtr &routes, quint64 &generation) const;
+
+    // 汇总所有转发器的I/O统计
+    VoiceIoStats stats() const;
+
+private:
+    void startMixer();
+    void stopMixer();
+
+    QVector<VoiceRelay*> m_relays;
+    VoiceMixer *m_mixer = nullptr;
+    QVector<QThread*> m_threads;
+    QString m_error;
+
+    mutable QMutex m_routesLock;
+    VoiceRoutesPtr m_routes;
+    std::atomic<quint64> m_routesGeneration{0};
+};
+
+#endif // VOICEPLANE_H
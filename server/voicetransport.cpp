@@ -0,0 +1,336 @@
+#include "voicetransport.h"
+#ifdef VOICEPHONE_HAVE_IO_URING
+#include "uringvoicetransport.h"
+#endif
+#include <QUdpSocket>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 基于QUdpSocket的后端，每个数据包一次 readDatagram / writeDatagram
+class QtVoiceTransport : public VoiceTransport
+{
+public:
+    explicit QtVoiceTransport(QObject *parent)
+        : VoiceTransport(parent)
+        , m_socket(new QUdpSocket(this))
+    {
+        QObject::connect(m_socket, &QUdpSocket::readyRead, this, [this]() { onReadyRead(); });
+    }
+
+    bool bind(quint16 port, bool reusePort) override
+    {
+        m_error.clear();
+        if (!reusePort) return m_socket->bind(QHostAddress::Any, port);
+
+#ifdef Q_OS_LINUX
+        // QUdpSocket的ShareAddress在Linux上只设置SO_REUSEADDR，因此自行创建套接字
+        int fd = openSocket(port, true, &m_error);
+        if (fd < 0) return false;
+        if (!m_socket->setSocketDescriptor(fd, QAbstractSocket::BoundState)) {
+            ::close(fd);
+            return false;
+        }
+        return true;
+#else
+        m_error = "SO_REUSEPORT sharding is only supported on Linux";
+        return false;
+#endif
+    }
+
+    void close() override { m_socket->close(); }
+    QString errorString() const override { return m_error.isEmpty() ? m_socket->errorString() : m_error; }
+    const char *name() const override { return "qt"; }
+
+    void send(const char *data, qsizetype size,
+              const VoiceDestination *destinations, qsizetype count, qsizetype skip) override
+    {
+        for (qsizetype i = 0; i < count; ++i) {
+            if (i == skip) continue;
+            m_socket->writeDatagram(data, size, destinations[i].address, destinations[i].port);
+            m_stats.packetsSent++;
+            m_stats.sendCalls++;
+        }
+    }
+
+private:
+    void onReadyRead()
+    {
+        while (m_socket->hasPendingDatagrams()) {
+            char *buffer = m_pool.acquire();
+            if (!buffer) {
+                // 池耗尽: 丢弃该数据包，避免readyRead反复触发
+                m_socket->readDatagram(nullptr, 0);
+                continue;
+            }
+
+            QHostAddress sender;
+            quint16 senderPort = 0;
+
+            // 超过缓冲区大小的数据包按无效包丢弃 (读取时会被截断，无法从返回值区分)
+            const qint64 pending = m_socket->pendingDatagramSize();
+            qint64 size = m_socket->readDatagram(buffer, VoiceBufferPool::BUFFER_SIZE, &sender, &senderPort);
+            m_stats.receiveCalls++;
+            if (size >= 0 && pending <= VoiceBufferPool::BUFFER_SIZE) {
+                m_stats.packetsReceived++;
+                if (m_receiveHandler) {
+                    m_receiveHandler(VoiceEndpoint::fromAddress(sender, senderPort), buffer, size);
+                }
+            }
+            m_pool.release(buffer);
+        }
+    }
+
+    QUdpSocket *m_socket;
+    QString m_error;
+};
+
+#ifdef Q_OS_LINUX
+
+// Linux批量后端: 一次 recvmmsg 读取多个数据包，一次 sendmmsg 发送整个转发集合
+class BatchedVoiceTransport : public VoiceTransport
+{
+public:
+    static constexpr int BATCH_SIZE = 64;
+
+    explicit BatchedVoiceTransport(QObject *parent)
+        : VoiceTransport(parent)
+    {
+    }
+
+    ~BatchedVoiceTransport() override { close(); }
+
+    bool bind(quint16 port, bool reusePort) override
+    {
+        close();
+
+        m_fd = openSocket(port, reusePort, &m_error);
+        if (m_fd < 0) return false;
+
+        // 消息头只设置一次，每次 recvmmsg 前仅填入缓冲区并恢复长度字段
+        for (int i = 0; i < BATCH_SIZE; ++i) {
+            m_rxMsgs[i].msg_hdr.msg_iov = &m_rxIov[i];
+            m_rxMsgs[i].msg_hdr.msg_iovlen = 1;
+            m_rxMsgs[i].msg_hdr.msg_name = &m_rxAddrs[i];
+        }
+
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        QObject::connect(m_notifier, &QSocketNotifier::activated, this, [this]() { onReadable(); });
+        return true;
+    }
+
+    void close() override
+    {
+        delete m_notifier;
+        m_notifier = nullptr;
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    QString errorString() const override { return m_error; }
+    const char *name() const override { return "batched"; }
+
+    void send(const char *data, qsizetype size,
+              const VoiceDestination *destinations, qsizetype count, qsizetype skip) override
+    {
+        if (m_fd < 0 || count <= 0) return;
+
+        iovec iov;
+        iov.iov_base = const_cast<char *>(data);
+        iov.iov_len = size_t(size);
+
+        qsizetype next = 0;
+        while (next < count) {
+            // 目标地址已预先转换，直接引用而不复制
+            int batch = 0;
+            for (; next < count && batch < BATCH_SIZE; ++next) {
+                if (next == skip) continue;
+                msghdr &hdr = m_txMsgs[batch++].msg_hdr;
+                hdr.msg_name = const_cast<sockaddr_in6 *>(&destinations[next].sockAddress);
+                hdr.msg_namelen = sizeof(sockaddr_in6);
+                hdr.msg_iov = &iov;
+                hdr.msg_iovlen = 1;
+            }
+            sendBatch(batch);
+        }
+    }
+
+private:
+    void sendBatch(int batch)
+    {
+        int offset = 0;
+        while (offset < batch) {
+            int sent = ::sendmmsg(m_fd, m_txMsgs + offset, unsigned(batch - offset), 0);
+            m_stats.sendCalls++;
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                // 发送缓冲区已满时丢弃剩余数据包 (UDP语义)
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                sent = 0;
+            }
+            m_stats.packetsSent += quint64(sent);
+            offset += sent;
+            // 跳过出错的目标 (例如不可达)，继续发送其余部分
+            if (offset < batch) offset++;
+        }
+    }
+
+    void onReadable()
+    {
+        for (;;) {
+            int slots = 0;
+            for (; slots < BATCH_SIZE; ++slots) {
+                char *buffer = m_pool.acquire();
+                if (!buffer) break;
+                m_rxIov[slots].iov_base = buffer;
+                m_rxIov[slots].iov_len = VoiceBufferPool::BUFFER_SIZE;
+                m_rxMsgs[slots].msg_hdr.msg_namelen = sizeof(m_rxAddrs[slots]);
+                m_rxMsgs[slots].msg_hdr.msg_flags = 0;
+            }
+            if (slots == 0) {
+                // 池耗尽: 丢弃一个数据包，避免通知器反复触发
+                char discard;
+                ::recv(m_fd, &discard, sizeof(discard), MSG_DONTWAIT | MSG_TRUNC);
+                return;
+            }
+
+            int received = ::recvmmsg(m_fd, m_rxMsgs, unsigned(slots), MSG_DONTWAIT, nullptr);
+            m_stats.receiveCalls++;
+            if (received < 0) {
+                releaseReceiveBuffers(slots);
+                if (errno == EINTR) continue;
+                return; // EAGAIN: 已读空
+            }
+            m_stats.packetsReceived += quint64(received);
+
+            for (int i = 0; i < received; ++i) {
+                const msghdr &hdr = m_rxMsgs[i].msg_hdr;
+                if ((hdr.msg_flags & MSG_TRUNC) || !m_receiveHandler) continue;
+
+                VoiceEndpoint from;
+                std::memcpy(from.address.c, m_rxAddrs[i].sin6_addr.s6_addr, sizeof(from.address.c));
+                from.port = ntohs(m_rxAddrs[i].sin6_port);
+                m_receiveHandler(from, static_cast<const char *>(m_rxIov[i].iov_base), qsizetype(m_rxMsgs[i].msg_len));
+            }
+
+            releaseReceiveBuffers(slots);
+            if (received < slots) return;
+        }
+    }
+
+    void releaseReceiveBuffers(int slots)
+    {
+        for (int i = 0; i < slots; ++i) {
+            m_pool.release(static_cast<char *>(m_rxIov[i].iov_base));
+        }
+    }
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QString m_error;
+
+    mmsghdr m_rxMsgs[BATCH_SIZE] = {};
+    iovec m_rxIov[BATCH_SIZE] = {};
+    sockaddr_in6 m_rxAddrs[BATCH_SIZE] = {};
+
+    mmsghdr m_txMsgs[BATCH_SIZE] = {};
+};
+
+#endif // Q_OS_LINUX
+
+} // namespace
+
+#ifdef Q_OS_LINUX
+
+// 创建并绑定双栈UDP套接字: IPv4客户端以 ::ffff:a.b.c.d 形式出现，与VoiceEndpoint的表示一致
+int VoiceTransport::openSocket(quint16 port, bool reusePort, QString *error)
+{
+    int fd = ::socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = QString::fromLocal8Bit(std::strerror(errno));
+        return -1;
+    }
+
+    int off = 0;
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    int on = 1;
+    if (reusePort && ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        *error = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    sockaddr_in6 addr = {};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        *error = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#endif // Q_OS_LINUX
+
+VoiceTransport *VoiceTransport::create(VoiceIoBackend backend, QObject *parent)
+{
+    switch (backend) {
+    case VoiceIoBackend::Uring:
+#ifdef VOICEPHONE_HAVE_IO_URING
+    {
+        QString reason;
+        if (VoiceTransport *transport = createUringVoiceTransport(parent, &reason)) {
+            return transport;
+        }
+        qWarning() << "io_uring voice I/O is not available:" << reason << "- falling back to batched I/O";
+    }
+#else
+        qWarning() << "Server was built without io_uring support, falling back to batched I/O";
+#endif
+        Q_FALLTHROUGH();
+    case VoiceIoBackend::Batched:
+#ifdef Q_OS_LINUX
+        return new BatchedVoiceTransport(parent);
+#else
+        qWarning() << "Batched voice I/O is only available on Linux, falling back to QUdpSocket";
+        break;
+#endif
+    case VoiceIoBackend::Qt:
+        break;
+    }
+    return new QtVoiceTransport(parent);
+}
+
+VoiceIoStats VoiceTransport::stats() const
+{
+    VoiceIoStats stats = m_stats;
+    const VoiceBufferPool::Stats &pool = m_pool.stats();
+    stats.poolCapacity = pool.capacity;
+    stats.poolInUse = pool.inUse;
+    stats.poolHighWater = pool.highWater;
+    stats.poolExhausted = pool.exhausted;
+    return stats;
+}
+
+VoiceIoBackend VoiceTransport::parseBackend(const QString &name, bool *ok)
+{
+    if (ok) *ok = true;
+    if (name == "batched") return VoiceIoBackend::Batched;
+    if (name == "uring") return VoiceIoBackend::Uring;
+    if (name != "qt" && ok) *ok = false;
+    return VoiceIoBackend::Qt;
+}
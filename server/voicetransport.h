@@ -0,0 +1,76 @@
+#ifndef VOICETRANSPORT_H
+#define VOICETRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#include <functional>
+#include "voicebufferpool.h"
+#include "voiceendpoint.h"
+
+// 语音端口的I/O后端
+enum class VoiceIoBackend {
+    Qt,      // QUdpSocket，每个数据包一次系统调用 (默认，全平台可用)
+    Batched, // recvmmsg/sendmmsg 批量收发 (仅Linux)
+    Uring    // io_uring 多发接收 + 批量提交发送 (仅Linux，需以 VOICEPHONE_IO_URING 构建)
+};
+
+// 语音I/O统计 (用于计算每次系统调用处理的数据包数)
+struct VoiceIoStats {
+    quint64 packetsReceived = 0;
+    quint64 receiveCalls = 0;
+    quint64 packetsSent = 0;
+    quint64 sendCalls = 0;
+
+    // 接收缓冲池使用情况
+    int poolCapacity = 0;
+    int poolInUse = 0;
+    int poolHighWater = 0;
+    quint64 poolExhausted = 0;
+};
+
+/**
+ * @brief UDP语音端口的收发接口
+ *
+ * 收到的数据包直接读入预分配的缓冲池，通过回调交给服务器，数据指针只在回调期间有效。
+ * 发送时一次传入整个转发目标集合，由后端决定如何合并系统调用。
+ */
+class VoiceTransport : public QObject
+{
+    Q_OBJECT
+public:
+    using ReceiveHandler = std::function<void(const VoiceEndpoint &from, const char *data, qsizetype size)>;
+
+    // 创建指定后端，不支持时回退 (io_uring -> 批量 -> QUdpSocket)
+    static VoiceTransport *create(VoiceIoBackend backend, QObject *parent = nullptr);
+    static VoiceIoBackend parseBackend(const QString &name, bool *ok = nullptr);
+
+    // reusePort: 以SO_REUSEPORT绑定，多个线程各自绑定同一端口由内核分流 (仅Linux)
+    virtual bool bind(quint16 port, bool reusePort = false) = 0;
+    virtual void close() = 0;
+    virtual QString errorString() const = 0;
+    virtual const char *name() const = 0;
+
+    // 将同一个数据包发送到多个目标，跳过下标为 skip 的目标 (发送者自身，-1表示不跳过)
+    virtual void send(const char *data, qsizetype size,
+                      const VoiceDestination *destinations, qsizetype count, qsizetype skip = -1) = 0;
+
+    void setReceiveHandler(ReceiveHandler handler) { m_receiveHandler = std::move(handler); }
+    virtual VoiceIoStats stats() const;
+
+protected:
+    // 两个完整批次: 处理当前批次时仍有余量，池耗尽即说明缓冲区被泄漏
+    static constexpr int RECEIVE_POOL_SIZE = 128;
+
+    explicit VoiceTransport(QObject *parent = nullptr) : QObject(parent), m_pool(RECEIVE_POOL_SIZE) {}
+
+#ifdef Q_OS_LINUX
+    // 创建并绑定双栈UDP套接字 (非阻塞)，失败时返回-1并设置 error
+    static int openSocket(quint16 port, bool reusePort, QString *error);
+#endif
+
+    ReceiveHandler m_receiveHandler;
+    VoiceIoStats m_stats;
+    VoiceBufferPool m_pool;
+};
+
+#endif // VOICETRANSPORT_H
@@ -1,7 +1,11 @@
 #include "audioengine.h"
 #include "opuscodec.h"
 #include "crypto.h"
+#include "pcmmix.h"
+#include "spscring.h"
+#include "voicepacket.h"
 
+#include <QAbstractEventDispatcher>
 #include <QAudioFormat>
 #include <QAudioSink>
 #include <QAudioSource>
@@ -9,174 +13,592 @@
 #include <QUdpSocket>
 #include <QHostAddress>
 #include <QByteArray>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
 #include <QDebug>
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// 网络线程和音频线程之间传递的UDP数据报，槽位大小固定，收发都不分配内存
+struct VoiceDatagram {
+    static constexpr int MAX_SIZE = 1500;
+
+    qint64 arrivalMs = 0; // 网络线程收到的时刻 (发送方向不使用)
+    qsizetype size = 0;
+    char data[MAX_SIZE];
+};
+
+// 音频线程发布给界面线程的发言者统计; active 为 false 表示该发言者已被移除
+struct SpeakerStats {
+    quint16 senderId = 0;
+    bool active = false;
+    JitterBuffer::Stats stats;
+};
+
+// 线程之间的全部数据通道，每个队列只有一个生产者线程和一个消费者线程
+struct AudioRings {
+    SpscRing<VoiceDatagram> incoming{128}; // 网络线程 -> 音频线程
+    SpscRing<VoiceDatagram> outgoing{64};  // 音频线程 -> 网络线程
+    SpscRing<SpeakerStats> stats{256};     // 音频线程 -> 界面线程
+};
+
+// 为当前线程启用实时调度，权限不足时保持原有调度
+static bool enableRealtimeScheduling()
+{
+#if defined(Q_OS_UNIX)
+    sched_param param {};
+    param.sched_priority = qMin(20, sched_get_priority_max(SCHED_FIFO));
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        qWarning() << "Failed to enable real-time scheduling for audio thread:" << strerror(error);
+        return false;
+    }
+    qInfo() << "Audio thread running with real-time scheduling";
+    return true;
+#else
+    // 其他平台上 TimeCriticalPriority 已是最高的线程优先级
+    return false;
+#endif
+}
+
+// 网络线程: 拥有UDP套接字，接收的数据报直接读入 incoming 队列的槽位，发送 outgoing 队列中的数据报
+class VoiceLink : public QObject
+{
+public:
+    VoiceLink(AudioRings *rings, const QElapsedTimer *clock)
+        : m_rings(rings)
+        , m_clock(clock)
+    {
+    }
+
+    bool open(quint16 localPort, const QHostAddress &serverAddress, quint16 serverPort)
+    {
+        close();
+        m_serverAddress = serverAddress;
+        m_serverPort = serverPort;
+
+        m_socket = new QUdpSocket(this);
+        if (!m_socket->bind(QHostAddress::AnyIPv4, localPort)) {
+            m_error = m_socket->errorString();
+            delete m_socket;
+            m_socket = nullptr;
+            return false;
+        }
+        connect(m_socket, &QUdpSocket::readyRead, this, [this]() { receive(); });
+
+        // 音频线程写入发送队列后唤醒本线程的事件分发器 (不加锁)，每次唤醒时发送排队的数据报
+        m_dispatcher = QAbstractEventDispatcher::instance();
+        m_awake = connect(m_dispatcher, &QAbstractEventDispatcher::awake, this, [this]() { sendPending(); });
+        return true;
+    }
+
+    void close()
+    {
+        disconnect(m_awake);
+        delete m_socket;
+        m_socket = nullptr;
+
+        // 本线程是发送队列的消费者，丢弃未发出的数据报
+        while (m_rings->outgoing.front()) {
+            m_rings->outgoing.pop();
+        }
+    }
+
+    QAbstractEventDispatcher *dispatcher() const { return m_dispatcher; }
+    QString errorString() const { return m_error; }
+
+private:
+    void receive()
+    {
+        while (m_socket->hasPendingDatagrams()) {
+            VoiceDatagram *datagram = m_rings->incoming.beginWrite();
+            if (!datagram) {
+                // 音频线程跟不上，丢弃数据报而不是等待
+                char discard;
+                m_socket->readDatagram(&discard, 0);
+                continue;
+            }
+            qint64 size = m_socket->readDatagram(datagram->data, VoiceDatagram::MAX_SIZE);
+            if (size <= 0) continue;
+            datagram->size = size;
+            datagram->arrivalMs = m_clock->elapsed();
+            m_rings->incoming.commitWrite();
+        }
+    }
+
+    void sendPending()
+    {
+        while (VoiceDatagram *datagram = m_rings->outgoing.front()) {
+            if (m_socket && m_serverPort != 0) {
+                m_socket->writeDatagram(datagram->data, datagram->size, m_serverAddress, m_serverPort);
+            }
+            m_rings->outgoing.pop();
+        }
+    }
+
+    AudioRings *m_rings;
+    const QElapsedTimer *m_clock;
+    QUdpSocket *m_socket = nullptr;
+    QAbstractEventDispatcher *m_dispatcher = nullptr;
+    QMetaObject::Connection m_awake;
+    QHostAddress m_serverAddress;
+    quint16 m_serverPort = 0;
+    QString m_error;
+};
+
+// 音频线程: 拥有音频设备、编解码器、抖动缓冲和混音器
+// 事件循环中只有音频设备通知和播放定时器，数据包经由队列与网络线程交换
+class AudioWorker : public QObject
+{
+public:
+    static constexpr int FRAME_SIZE = 960;  // 20ms @ 48kHz
+    static constexpr int SAMPLE_RATE = 48000;
+    static constexpr int CHANNELS = 1;
+    static constexpr int BYTES_PER_FRAME = FRAME_SIZE * CHANNELS * 2; // int16 = 2 bytes
+    static constexpr int IDLE_TICKS = 250;  // 5秒没有数据的发言者回收其缓冲和解码器
+    static constexpr int STATS_TICKS = 50;  // 每秒向界面线程发布一次统计
+
+    explicit AudioWorker(AudioRings *rings)
+        : m_rings(rings)
+    {
+        m_codec = new OpusCodec();
+        m_decoderPool = new OpusDecoderPool(SAMPLE_RATE, CHANNELS);
+        m_mixFrame.resize(FRAME_SIZE * CHANNELS);
+        m_decodeFrame.resize(FRAME_SIZE * CHANNELS);
+        m_captureFrame.resize(FRAME_SIZE * CHANNELS);
+
+        // 初始化Opus编码器（48kHz, 单声道, 24kbps）
+        if (!m_codec->initialize(SAMPLE_RATE, CHANNELS, 24000, OpusCodec::EncoderOnly)) {
+            qWarning() << "Failed to initialize Opus codec:" << m_codec->lastError();
+        }
+    }
+
+    ~AudioWorker()
+    {
+        stop();
+        delete m_decoderPool;
+        delete m_codec;
+    }
+
+    void setEncryptionKey(const QByteArray &key)
+    {
+        if (key.isEmpty()) {
+            m_cipher.clear();
+        } else if (m_cipher.setKey(key)) {
+            qInfo() << "Encryption key set for audio engine";
+        }
+    }
+
+    void setSenderId(quint16 senderId) { m_senderId = senderId; }
+
+    void start(QAbstractEventDispatcher *networkDispatcher, bool realtime)
+    {
+        stop();
+        m_networkDispatcher = networkDispatcher;
+        if (realtime && !m_realtime) {
+            m_realtime = enableRealtimeScheduling();
+        }
+
+        QAudioFormat format;
+        format.setSampleRate(SAMPLE_RATE);
+        format.setChannelCount(CHANNELS);
+        format.setSampleFormat(QAudioFormat::Int16);
+
+        m_audioSource = new QAudioSource(format, this);
+        m_audioSink = new QAudioSink(format, this);
+
+        m_inputDevice = m_audioSource->start();
+        m_outputDevice = m_audioSink->start();
+
+        if (m_inputDevice) {
+            connect(m_inputDevice, &QIODevice::readyRead, this, [this]() { handleAudioReady(); });
+        }
+
+        // 丢弃上次未凑满的一帧
+        m_captureFill = 0;
+
+        // 序号和时间戳从随机值开始 (与RTP相同)，新的发送流不会与之前的nonce重复
+        m_sequence = QRandomGenerator::global()->generate();
+        m_timestamp = QRandomGenerator::global()->generate();
+        m_marker = true;
+
+        // 播放时钟: 每20ms从每个发言者的抖动缓冲取出一帧
+        if (!m_playoutTimer) {
+            m_playoutTimer = new QTimer(this);
+            m_playoutTimer->setTimerType(Qt::PreciseTimer);
+            m_playoutTimer->setInterval(FRAME_SIZE * 1000 / SAMPLE_RATE);
+            connect(m_playoutTimer, &QTimer::timeout, this, [this]() { playoutTick(); });
+        }
+        m_playoutTimer->start();
+        m_ticks = 0;
+    }
+
+    void stop()
+    {
+        if (m_playoutTimer) {
+            m_playoutTimer->stop();
+        }
+        releaseSpeakers();
+
+        if (m_audioSource) {
+            m_audioSource->stop();
+            delete m_audioSource;
+            m_audioSource = nullptr;
+            m_inputDevice = nullptr;
+        }
+        if (m_audioSink) {
+            m_audioSink->stop();
+            delete m_audioSink;
+            m_audioSink = nullptr;
+            m_outputDevice = nullptr;
+        }
+
+        // 本线程是接收队列的消费者，丢弃尚未处理的数据报
+        while (m_rings->incoming.front()) {
+            m_rings->incoming.pop();
+        }
+
+        m_captureFill = 0;
+    }
+
+private:
+    // 远端发言者: 独立的抖动缓冲和解码器状态
+    struct RemoteSpeaker {
+        explicit RemoteSpeaker(int frameSamples, int sampleRate) : jitter(frameSamples, sampleRate) {}
+        JitterBuffer jitter;
+        OpusDecoder *decoder = nullptr; // 从 m_decoderPool 取出，移除发言者时归还
+    };
+
+    void handleAudioReady()
+    {
+        if (!m_inputDevice || !m_codec->isInitialized()) return;
+
+        // 直接读入固定的一帧缓冲区，凑满一帧就编码发送，不经过中间缓冲，也不移动剩余数据
+        char *frame = reinterpret_cast<char*>(m_captureFrame.data());
+        for (;;) {
+            qint64 bytesRead = m_inputDevice->read(frame + m_captureFill, BYTES_PER_FRAME - m_captureFill);
+            if (bytesRead <= 0) break;
+            m_captureFill += int(bytesRead);
+            if (m_captureFill == BYTES_PER_FRAME) {
+                sendFrame(m_captureFrame.constData());
+                m_captureFill = 0;
+            }
+        }
+    }
+
+    // 头部、Opus数据和认证标签依次写入同一个预先分配的数据包缓冲区，每帧不分配内存
+    void sendFrame(const qint16 *pcm)
+    {
+        // 数据包直接写入发送队列的槽位；队列已满 (网络线程停顿) 时写入暂存区后丢弃，
+        // 编码器状态和序号仍保持连续
+        VoiceDatagram *slot = m_rings->outgoing.beginWrite();
+        VoiceDatagram *packet = slot ? slot : &m_overflowPacket;
+        char *payload = packet->data + VoicePacket::HEADER_SIZE;
+        const int maxPayload = VoiceDatagram::MAX_SIZE - VoicePacket::HEADER_SIZE - VoicePacket::TAG_SIZE;
+
+        // 使用Opus编码
+        const int encodedSize = m_codec->encode(pcm, FRAME_SIZE, payload, maxPayload);
+
+        if (encodedSize > 0) {
+            // 音频电平放在明文头部，供服务器选择转发最响的发言者
+            VoicePacket::Header header;
+            header.flags = m_marker ? VoicePacket::FLAG_MARKER : 0;
+            header.level = VoicePacket::audioLevel(pcm, FRAME_SIZE * CHANNELS);
+            header.senderId = m_senderId;
+            header.sequence = m_sequence;
+            header.timestamp = m_timestamp;
+            VoicePacket::writeHeader(packet->data, header);
+
+            // 使用频道密钥加密并认证音频数据（端到端加密）: 头部作为附加数据，
+            // Opus数据在数据包缓冲区内原地加密，认证标签紧随其后
+            const bool encrypted = m_cipher.isValid();
+            bool ok = true;
+            if (encrypted) {
+                QByteArrayView aad(packet->data, VoicePacket::HEADER_SIZE);
+                ok = m_cipher.sealGCM(payload, encodedSize, aad, VoicePacket::nonce(header),
+                                      payload + encodedSize);
+            }
+
+            if (slot && ok) {
+                packet->size = VoicePacket::HEADER_SIZE + encodedSize + (encrypted ? VoicePacket::TAG_SIZE : 0);
+                m_rings->outgoing.commitWrite();
+                m_networkDispatcher->wakeUp();
+                m_marker = false;
+            }
+
+            m_sequence++;
+        }
+        // 时间戳按采样前进，未发送的帧在接收端表现为时间间隔
+        m_timestamp += FRAME_SIZE;
+    }
+
+    // 取出网络线程收到的数据报，校验解密后按发言者放入抖动缓冲
+    void receivePending()
+    {
+        while (VoiceDatagram *datagram = m_rings->incoming.front()) {
+            receive(datagram->data, datagram->size, datagram->arrivalMs);
+            m_rings->incoming.pop();
+        }
+    }
+
+    void receive(char *data, qsizetype size, qint64 arrivalMs)
+    {
+        VoicePacket::Header header;
+        if (size <= VoicePacket::HEADER_SIZE || !VoicePacket::readHeader(data, size, &header)) return;
+
+        // 使用频道密钥校验并解密音频数据（端到端加密），在队列槽位内原地解密
+        // 标签不符的数据包 (损坏、伪造或使用其他密钥) 在解码之前丢弃
+        char *payload = data + VoicePacket::HEADER_SIZE;
+        qsizetype payloadSize = size - VoicePacket::HEADER_SIZE;
+        if (m_cipher.isValid()) {
+            QByteArrayView aad(data, VoicePacket::HEADER_SIZE);
+            payloadSize -= VoicePacket::TAG_SIZE;
+            if (payloadSize <= 0
+                || !m_cipher.openGCM(payload, payloadSize, aad, VoicePacket::nonce(header),
+                                     payload + payloadSize)) {
+                return;
+            }
+        }
+
+        // 同一时刻只会收到一路服务器混音，换到另一路 (本客户端开始或停止发言) 时
+        // 旧的一路是服务器有意停发: 播放完已缓冲的帧即结束，不以PLC补帧
+        if ((header.flags & VoicePacket::FLAG_MIXED) && header.senderId != m_mixedStream) {
+            if (RemoteSpeaker *previous = m_speakers.value(m_mixedStream).get()) {
+                previous->jitter.endStream();
+            }
+            m_mixedStream = header.senderId;
+        }
+
+        // 按发送者ID放入抖动缓冲，由播放时钟重新排序后解码
+        std::shared_ptr<RemoteSpeaker> &speaker = m_speakers[header.senderId];
+        if (!speaker) {
+            OpusDecoder *decoder = m_decoderPool->acquire();
+            if (!decoder) {
+                m_speakers.remove(header.senderId);
+                return;
+            }
+            speaker = std::make_shared<RemoteSpeaker>(FRAME_SIZE, SAMPLE_RATE);
+            speaker->decoder = decoder;
+        }
+        speaker->jitter.push(header.sequence, header.timestamp, (header.flags & VoicePacket::FLAG_MARKER) != 0,
+                             payload, payloadSize, arrivalMs);
+    }
+
+    void playoutTick()
+    {
+        receivePending();
+
+        const int samples = FRAME_SIZE * CHANNELS;
+        qint16 *mix = m_mixFrame.data();
+        int mixed = 0;
+        const bool publish = ++m_ticks % STATS_TICKS == 0;
+
+        for (auto it = m_speakers.begin(); it != m_speakers.end();) {
+            RemoteSpeaker &speaker = *it.value();
+            QByteArrayView payload;
+            int frameSamples = 0;
+            // 本周期第一个有输出的发言者直接解码到播放帧，之后的发言者解码到暂存帧再叠加
+            qint16 *decoded = mixed == 0 ? mix : m_decodeFrame.data();
+            switch (speaker.jitter.pop(&payload)) {
+            case JitterBuffer::Result::Packet:
+                frameSamples = OpusDecoderPool::decode(speaker.decoder, payload.data(), payload.size(),
+                                                       decoded, FRAME_SIZE);
+                break;
+            case JitterBuffer::Result::Missing:
+                // 缺失的帧使用该发言者解码器的丢包隐藏补出
+                frameSamples = OpusDecoderPool::decode(speaker.decoder, nullptr, 0, decoded, FRAME_SIZE);
+                break;
+            case JitterBuffer::Result::Empty:
+                if (speaker.jitter.idleTicks() >= IDLE_TICKS) {
+                    SpeakerStats removed;
+                    removed.senderId = it.key();
+                    m_rings->stats.push(removed);
+                    m_decoderPool->release(speaker.decoder);
+                    it = m_speakers.erase(it);
+                    continue;
+                }
+                break;
+            }
+
+            if (frameSamples > 0) {
+                const int decodedSamples = qMin(frameSamples, FRAME_SIZE) * CHANNELS;
+                if (mixed == 0) {
+                    // 不足一帧时补静音
+                    PcmMix::clear(mix + decodedSamples, samples - decodedSamples);
+                } else {
+                    // SIMD饱和加法叠加到本周期的播放帧
+                    PcmMix::addSaturate(mix, decoded, decodedSamples);
+                }
+                mixed++;
+            }
+            if (publish) {
+                // 界面线程来不及读取时丢弃本次统计，不等待
+                SpeakerStats stats;
+                stats.senderId = it.key();
+                stats.active = true;
+                stats.stats = speaker.jitter.stats();
+                m_rings->stats.push(stats);
+            }
+            ++it;
+        }
+
+        if (mixed > 0 && m_outputDevice) {
+            m_outputDevice->write(reinterpret_cast<const char*>(mix), BYTES_PER_FRAME);
+        }
+    }
+
+    void releaseSpeakers()
+    {
+        for (const std::shared_ptr<RemoteSpeaker> &speaker : std::as_const(m_speakers)) {
+            m_decoderPool->release(speaker->decoder);
+        }
+        m_speakers.clear();
+        m_mixedStream = 0;
+    }
+
+    AudioRings *m_rings;
+    QAbstractEventDispatcher *m_networkDispatcher = nullptr;
+    bool m_realtime = false;
+
+    QAudioSource *m_audioSource = nullptr;
+    QAudioSink *m_audioSink = nullptr;
+    QIODevice *m_inputDevice = nullptr;
+    QIODevice *m_outputDevice = nullptr;
+
+    // Opus编码器 (解码由每个发言者各自的解码器完成)
+    OpusCodec *m_codec = nullptr;
+
+    // 接收的数据包按发言者放入抖动缓冲，播放定时器每帧从所有发言者各取一帧，
+    // 解码后用饱和加法混成一个20ms的播放帧 (第一个发言者直接解码到 m_mixFrame)
+    QHash<quint16, std::shared_ptr<RemoteSpeaker>> m_speakers;
+    quint16 m_mixedStream = 0; // 最近收到的服务器混音流的发送者ID，0 表示没有
+    OpusDecoderPool *m_decoderPool = nullptr;
+    QVector<qint16> m_mixFrame;
+    QVector<qint16> m_decodeFrame;
+    QTimer *m_playoutTimer = nullptr;
+    quint64 m_ticks = 0;
+
+    // 加密相关: 频道密钥的上下文只在设置密钥时初始化，每个数据包只重设nonce
+    AesContext m_cipher;
+
+    // 数据包头部状态，每次 start() 时序号和时间戳从随机值开始
+    quint16 m_senderId = 0;
+    quint32 m_sequence = 0;
+    quint32 m_timestamp = 0;
+    bool m_marker = true;
+
+    // 发送缓冲区，启动时一次分配
+    QVector<qint16> m_captureFrame; // 正在凑满的一帧PCM
+    int m_captureFill = 0;          // m_captureFrame 中已读入的字节数
+    VoiceDatagram m_overflowPacket; // 发送队列已满时的编码暂存区
+};
 
 AudioEngine::AudioEngine(QObject *parent)
     : QObject(parent)
-    , m_audioCounter(nullptr)
+    , m_rings(std::make_unique<AudioRings>())
 {
-    m_socket = new QUdpSocket(this);
-    m_codec = new OpusCodec();
-    
-    // 初始化Opus编解码器（48kHz, 单声道, 24kbps）
-    if (!m_codec->initialize(SAMPLE_RATE, CHANNELS, 24000)) {
-        qWarning() << "Failed to initialize Opus codec:" << m_codec->lastError();
-    }
+    m_clock.start();
+
+    m_networkThread = new QThread;
+    m_networkThread->setObjectName("voice-network");
+    m_link = new VoiceLink(m_rings.get(), &m_clock);
+    m_link->moveToThread(m_networkThread);
+    connect(m_networkThread, &QThread::finished, m_link, &QObject::deleteLater);
+    m_networkThread->start(QThread::HighPriority);
+
+    m_audioThread = new QThread;
+    m_audioThread->setObjectName("voice-audio");
+    m_audioWorker = new AudioWorker(m_rings.get());
+    m_audioWorker->moveToThread(m_audioThread);
+    connect(m_audioThread, &QThread::finished, m_audioWorker, &QObject::deleteLater);
+    m_audioThread->start(QThread::TimeCriticalPriority);
 }
 
 AudioEngine::~AudioEngine()
 {
     stop();
-    delete m_codec;
+
+    // 两个线程的对象都在各自线程退出时删除，之后才释放它们共用的队列
+    for (QThread *thread : {m_audioThread, m_networkThread}) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
 }
 
 void AudioEngine::setEncryptionKey(const QByteArray &key)
 {
-    m_encryptionKey = key;
-    if (!key.isEmpty()) {
-        qInfo() << "Encryption key set for audio engine";
-    }
+    AudioWorker *worker = m_audioWorker;
+    QMetaObject::invokeMethod(worker, [worker, key]() { worker->setEncryptionKey(key); });
 }
 
-void AudioEngine::setAudioCounter(quint64 *counter)
+void AudioEngine::setSenderId(quint16 senderId)
 {
-    m_audioCounter = counter;
+    AudioWorker *worker = m_audioWorker;
+    QMetaObject::invokeMethod(worker, [worker, senderId]() { worker->setSenderId(senderId); });
 }
 
 void AudioEngine::start(const QString &serverIp, quint16 voicePort, quint16 localPort)
 {
     stop();
 
-    QAudioFormat format;
-    format.setSampleRate(SAMPLE_RATE);
-    format.setChannelCount(CHANNELS);
-    format.setSampleFormat(QAudioFormat::Int16);
-
-    m_audioSource = new QAudioSource(format, this);
-    m_audioSink = new QAudioSink(format, this);
-
-    m_inputDevice = m_audioSource->start();
-    m_outputDevice = m_audioSink->start();
-
-    if (m_inputDevice) {
-        connect(m_inputDevice, &QIODevice::readyRead, this, &AudioEngine::handleAudioReady);
+    // 绑定本地端口接收音频 (套接字在网络线程内创建)
+    VoiceLink *link = m_link;
+    QHostAddress serverAddress(serverIp);
+    bool ok = false;
+    QString error;
+    QAbstractEventDispatcher *dispatcher = nullptr;
+    QMetaObject::invokeMethod(link, [link, localPort, serverAddress, voicePort, &ok, &error, &dispatcher]() {
+        ok = link->open(localPort, serverAddress, voicePort);
+        error = link->errorString();
+        dispatcher = link->dispatcher();
+    }, Qt::BlockingQueuedConnection);
+    if (!ok) {
+        qWarning() << "Failed to bind UDP socket:" << error;
+        return;
     }
 
-    m_serverAddress = QHostAddress(serverIp);
-    m_serverPort = voicePort;
-    
-    // 清空缓冲区
-    m_captureBuffer.clear();
+    // 音频设备在音频线程内创建
+    AudioWorker *worker = m_audioWorker;
+    const bool realtime = m_realtime;
+    QMetaObject::invokeMethod(worker, [worker, dispatcher, realtime]() {
+        worker->start(dispatcher, realtime);
+    }, Qt::BlockingQueuedConnection);
 
-    // 绑定本地端口接收音频
-    if (m_socket->bind(QHostAddress::AnyIPv4, localPort)) {
-        connect(m_socket, &QUdpSocket::readyRead, this, &AudioEngine::handleSocketReadyRead);
-        m_isRunning = true;
-        qInfo() << "Audio engine started with Opus codec - Server:" << serverIp << ":" << voicePort << "Local:" << localPort;
-    } else {
-        qWarning() << "Failed to bind UDP socket:" << m_socket->errorString();
-    }
+    m_isRunning = true;
+    qInfo() << "Audio engine started with Opus codec - Server:" << serverIp << ":" << voicePort << "Local:" << localPort;
 }
 
 void AudioEngine::stop()
 {
-    m_isRunning = false;
-    
-    if (m_audioSource) {
-        m_audioSource->stop();
-        delete m_audioSource;
-        m_audioSource = nullptr;
-        m_inputDevice = nullptr;
-    }
-    if (m_audioSink) {
-        m_audioSink->stop();
-        delete m_audioSink;
-        m_audioSink = nullptr;
-        m_outputDevice = nullptr;
-    }
-    if (m_socket) {
-        m_socket->close();
-    }
-    
-    // 清空缓冲区
-    m_captureBuffer.clear();
-}
+    // 先停止音频线程，它不再向发送队列写入后再关闭套接字
+    AudioWorker *worker = m_audioWorker;
+    QMetaObject::invokeMethod(worker, [worker]() { worker->stop(); }, Qt::BlockingQueuedConnection);
+    VoiceLink *link = m_link;
+    QMetaObject::invokeMethod(link, [link]() { link->close(); }, Qt::BlockingQueuedConnection);
 
-void AudioEngine::handleAudioReady()
-{
-    if (!m_inputDevice || !m_socket || !m_isRunning || !m_codec || !m_codec->isInitialized()) return;
-    
-    // 读取所有可用数据并添加到缓冲区
-    QByteArray data = m_inputDevice->readAll();
-    if (!data.isEmpty()) {
-        m_captureBuffer.append(data);
-    }
-    
-    // 当缓冲区有足够数据时，编码并发送
-    while (m_captureBuffer.size() >= BYTES_PER_FRAME) {
-        // 提取一帧数据
-        QByteArray frame = m_captureBuffer.left(BYTES_PER_FRAME);
-        m_captureBuffer.remove(0, BYTES_PER_FRAME);
-        
-        // 使用Opus编码
-        QByteArray encoded = m_codec->encode(frame, FRAME_SIZE);
-        
-        if (!encoded.isEmpty() && m_serverPort != 0) {
-            // 使用频道密钥加密音频数据（端到端加密）
-            if (!m_encryptionKey.isEmpty() && m_audioCounter) {
-                QByteArray encrypted = CryptoUtils::encryptAES_CTR(encoded, m_encryptionKey, *m_audioCounter);
-                if (!encrypted.isEmpty()) {
-                    // 将计数器添加到数据包前面（8字节）
-                    QByteArray packet;
-                    packet.resize(8);
-                    for (int i = 0; i < 8; ++i) {
-                        packet[i] = (*m_audioCounter >> (56 - i * 8)) & 0xFF;
-                    }
-                    packet.append(encrypted);
-                    m_socket->writeDatagram(packet, m_serverAddress, m_serverPort);
-                    (*m_audioCounter)++; // 递增计数器
-                }
-            } else {
-                // 没有加密密钥，发送明文
-                m_socket->writeDatagram(encoded, m_serverAddress, m_serverPort);
-            }
-        }
+    m_isRunning = false;
+    m_jitterStats.clear();
+    SpeakerStats stale;
+    while (m_rings->stats.tryPop(&stale)) {
     }
 }
 
-void AudioEngine::handleSocketReadyRead()
+QHash<quint16, JitterBuffer::Stats> AudioEngine::jitterStats()
 {
-    if (!m_codec || !m_codec->isInitialized()) return;
-    
-    while (m_socket->hasPendingDatagrams()) {
-        QByteArray datagram;
-        datagram.resize(int(m_socket->pendingDatagramSize()));
-        QHostAddress sender;
-        quint16 senderPort;
-        m_socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        
-        if (!datagram.isEmpty()) {
-            // 使用频道密钥解密音频数据（端到端加密）
-            QByteArray toDecode = datagram;
-            if (!m_encryptionKey.isEmpty() && datagram.size() > 8) {
-                // 从数据包前8字节提取计数器
-                quint64 counter = 0;
-                for (int i = 0; i < 8; ++i) {
-                    counter = (counter << 8) | (static_cast<unsigned char>(datagram[i]));
-                }
-                
-                // 解密剩余数据
-                QByteArray encrypted = datagram.mid(8);
-                toDecode = CryptoUtils::decryptAES_CTR(encrypted, m_encryptionKey, counter);
-            }
-            
-            // 使用Opus解码
-            QByteArray decoded = m_codec->decode(toDecode, FRAME_SIZE);
-            
-            if (!decoded.isEmpty() && m_outputDevice) {
-                // 播放解码后的PCM数据
-                m_outputDevice->write(decoded);
-            }
+    SpeakerStats update;
+    while (m_rings->stats.tryPop(&update)) {
+        if (update.active) {
+            m_jitterStats.insert(update.senderId, update.stats);
+        } else {
+            m_jitterStats.remove(update.senderId);
         }
     }
+    return m_jitterStats;
 }
@@ -2,17 +2,26 @@
 #define AUDIOENGINE_H
 
 #include <QObject>
-#include <QHostAddress>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <memory>
+#include "jitterbuffer.h"
 
-class QAudioInput;
-class QAudioOutput;
-class QAudioSink;
-class QAudioSource;
-class QUdpSocket;
-class QIODevice;
-class OpusCodec;
+class QThread;
+class AudioWorker;
+class VoiceLink;
+struct AudioRings;
 
+/**
+ * @brief 音频引擎
+ *
+ * 采集 -> 编码 -> 加密 以及 抖动缓冲 -> 解码 -> 混音 -> 播放 在专用的高优先级音频线程上运行，
+ * UDP收发在单独的网络线程上运行。数据包和统计在线程之间只通过单生产者/单消费者无锁环形队列传递，
+ * 界面重绘或阻塞的对话框不会让音频停顿，音频线程也从不等待锁或其他线程的事件循环。
+ *
+ * 公共接口在界面线程调用；start/stop 等待音频线程和网络线程完成设备和套接字的创建或释放。
+ */
 class AudioEngine : public QObject
 {
     Q_OBJECT
@@ -23,38 +32,29 @@ public:
     void start(const QString &serverIp, quint16 voicePort, quint16 localPort);
     void stop();
     bool isRunning() const { return m_isRunning; }
-    
-    // 设置加密密钥和计数器
+
+    // 设置加密密钥和服务器分配的发送者ID
     void setEncryptionKey(const QByteArray &key);
-    void setAudioCounter(quint64 *counter); // 指向MainWindow中的计数器
+    void setSenderId(quint16 senderId);
+
+    // 音频线程使用实时调度 (Linux/macOS 上为 SCHED_FIFO，需要相应权限，失败时保持最高的普通优先级)
+    // 需在 start 之前调用
+    void setRealtimeScheduling(bool enabled) { m_realtime = enabled; }
 
-private slots:
-    void handleAudioReady();
-    void handleSocketReadyRead();
+    // 每个发言者 (按发送者ID) 的抖动缓冲状态: 深度、迟到和丢失的帧数
+    // 由音频线程定期发布，返回最近一次发布的状态
+    QHash<quint16, JitterBuffer::Stats> jitterStats();
 
 private:
-    QAudioSource *m_audioSource = nullptr;
-    QAudioSink *m_audioSink = nullptr;
-    QUdpSocket *m_socket = nullptr;
-    QIODevice *m_inputDevice = nullptr;
-    QIODevice *m_outputDevice = nullptr;
-    QHostAddress m_serverAddress;
-    quint16 m_serverPort = 0;
+    QThread *m_audioThread = nullptr;
+    QThread *m_networkThread = nullptr;
+    AudioWorker *m_audioWorker = nullptr;
+    VoiceLink *m_link = nullptr;
+    std::unique_ptr<AudioRings> m_rings;
+    QElapsedTimer m_clock; // 数据包到达时刻，各线程共用的单调时钟
+    QHash<quint16, JitterBuffer::Stats> m_jitterStats;
     bool m_isRunning = false;
-    
-    // Opus编解码器
-    OpusCodec *m_codec = nullptr;
-    
-    // 加密相关
-    QByteArray m_encryptionKey;
-    quint64 *m_audioCounter = nullptr; // 指向外部计数器
-    
-    // 音频缓冲区
-    QByteArray m_captureBuffer;  // 捕获的PCM数据缓冲
-    static constexpr int FRAME_SIZE = 960;  // 20ms @ 48kHz
-    static constexpr int SAMPLE_RATE = 48000;
-    static constexpr int CHANNELS = 1;
-    static constexpr int BYTES_PER_FRAME = FRAME_SIZE * CHANNELS * 2; // int16 = 2 bytes
+    bool m_realtime = false;
 };
 
 #endif // AUDIOENGINE_H
@@ -0,0 +1,314 @@
+#include "controlcodec.h"
+#include <QJsonArray>
+#include <QJsonValue>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 只能在末尾追加
+const char *const MESSAGE_TYPES[] = {
+    "register", "register_success", "login", "login_success", "error",
+    "join_channel", "join_success", "leave_channel", "leave_success",
+    "get_channels", "channel_list", "user_list", "user_joined", "user_left",
+    "set_channel_settings", "channel_settings", "redirect", "presence_delta",
+    "resume", "resume_success", "logout", "get_user_list",
+};
+
+// 只能在末尾追加
+const char *const FIELD_NAMES[] = {
+    "username", "password_hash", "udp_ip", "udp_port", "message",
+    "session_id", "session_key", "voice_port", "voice_id", "encoding",
+    "channel", "channel_key", "channels", "users", "name", "user_count",
+    "mixing", "last_n", "node", "host", "control_port",
+    "presence", "presence_version", "version", "from_version", "joined", "left",
+    "ticket", "resume_ticket", "resume_grace",
+};
+
+enum Tag : quint8 {
+    TAG_NULL = 0,
+    TAG_FALSE = 1,
+    TAG_TRUE = 2,
+    TAG_INT = 3,
+    TAG_DOUBLE = 4,
+    TAG_STRING = 5,
+    TAG_ARRAY = 6,
+    TAG_OBJECT = 7,
+    TAG_BYTES = 8,
+};
+
+// 以十六进制字符串表示的二进制字段
+const char *const BYTES_FIELDS[] = {
+    "session_key", "channel_key",
+};
+
+constexpr int MAX_DEPTH = 16;
+
+template <size_t N>
+int findName(const char *const (&table)[N], const QString &name)
+{
+    for (size_t i = 0; i < N; ++i) {
+        if (name == QLatin1String(table[i])) return int(i);
+    }
+    return -1;
+}
+
+void writeVarint(QByteArray *out, quint64 value)
+{
+    while (value >= 0x80) {
+        out->append(char(value | 0x80));
+        value >>= 7;
+    }
+    out->append(char(value));
+}
+
+void writeString(QByteArray *out, const QString &s)
+{
+    QByteArray utf8 = s.toUtf8();
+    writeVarint(out, quint64(utf8.size()));
+    out->append(utf8);
+}
+
+// 已知名称写为 (下标 << 1) | 1，其他写为 (长度 << 1) + UTF-8
+template <size_t N>
+void writeName(QByteArray *out, const char *const (&table)[N], const QString &name)
+{
+    int index = findName(table, name);
+    if (index >= 0) {
+        writeVarint(out, (quint64(index) << 1) | 1);
+        return;
+    }
+    QByteArray utf8 = name.toUtf8();
+    writeVarint(out, quint64(utf8.size()) << 1);
+    out->append(utf8);
+}
+
+void writeValue(QByteArray *out, const QJsonValue &value);
+
+// 小写十六进制字符串写为字节串；其他内容 (解码后无法还原为同一字符串) 返回false，按普通字符串编码
+bool writeHexBytes(QByteArray *out, const QString &hex)
+{
+    const QByteArray latin1 = hex.toLatin1();
+    const QByteArray bytes = QByteArray::fromHex(latin1);
+    if (bytes.toHex() != latin1) return false;
+    out->append(char(TAG_BYTES));
+    writeVarint(out, quint64(bytes.size()));
+    out->append(bytes);
+    return true;
+}
+
+void writeObject(QByteArray *out, const QJsonObject &object, bool skipType)
+{
+    writeVarint(out, quint64(object.size() - (skipType && object.contains("type") ? 1 : 0)));
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        if (skipType && it.key() == QLatin1String("type")) continue;
+        writeName(out, FIELD_NAMES, it.key());
+        if (it.value().isString() && findName(BYTES_FIELDS, it.key()) >= 0
+            && writeHexBytes(out, it.value().toString())) {
+            continue;
+        }
+        writeValue(out, it.value());
+    }
+}
+
+void writeValue(QByteArray *out, const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        out->append(char(value.toBool() ? TAG_TRUE : TAG_FALSE));
+        break;
+    case QJsonValue::Double: {
+        double d = value.toDouble();
+        // JSON中的数字都是double，能无损表示为整数的按zigzag varint编码
+        if (std::floor(d) == d && std::fabs(d) <= 9007199254740992.0) {
+            qint64 i = qint64(d);
+            out->append(char(TAG_INT));
+            writeVarint(out, (quint64(i) << 1) ^ quint64(i >> 63));
+        } else {
+            out->append(char(TAG_DOUBLE));
+            char bytes[8];
+            std::memcpy(bytes, &d, sizeof(bytes));
+            out->append(bytes, sizeof(bytes));
+        }
+        break;
+    }
+    case QJsonValue::String:
+        out->append(char(TAG_STRING));
+        writeString(out, value.toString());
+        break;
+    case QJsonValue::Array: {
+        const QJsonArray array = value.toArray();
+        out->append(char(TAG_ARRAY));
+        writeVarint(out, quint64(array.size()));
+        for (const QJsonValue &element : array) {
+            writeValue(out, element);
+        }
+        break;
+    }
+    case QJsonValue::Object:
+        out->append(char(TAG_OBJECT));
+        writeObject(out, value.toObject(), false);
+        break;
+    default:
+        out->append(char(TAG_NULL));
+        break;
+    }
+}
+
+class Reader
+{
+public:
+    explicit Reader(QByteArrayView data) : m_data(data) {}
+
+    bool atEnd() const { return m_pos == m_data.size(); }
+
+    bool readVarint(quint64 *value)
+    {
+        quint64 result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos >= m_data.size()) return false;
+            quint8 byte = quint8(m_data[m_pos++]);
+            result |= quint64(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                *value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readBytes(quint64 size, QByteArrayView *bytes)
+    {
+        if (size > quint64(m_data.size() - m_pos)) return false;
+        *bytes = m_data.sliced(m_pos, qsizetype(size));
+        m_pos += qsizetype(size);
+        return true;
+    }
+
+    template <size_t N>
+    bool readName(const char *const (&table)[N], QString *name)
+    {
+        quint64 v;
+        if (!readVarint(&v)) return false;
+        if (v & 1) {
+            quint64 index = v >> 1;
+            if (index >= N) return false;
+            *name = QLatin1String(table[index]);
+            return true;
+        }
+        QByteArrayView utf8;
+        if (!readBytes(v >> 1, &utf8)) return false;
+        *name = QString::fromUtf8(utf8);
+        return true;
+    }
+
+    bool readObject(QJsonObject *object, int depth)
+    {
+        quint64 count;
+        if (!readVarint(&count) || count > quint64(m_data.size())) return false;
+        for (quint64 i = 0; i < count; ++i) {
+            QString key;
+            QJsonValue value;
+            if (!readName(FIELD_NAMES, &key) || !readValue(&value, depth)) return false;
+            object->insert(key, value);
+        }
+        return true;
+    }
+
+    bool readValue(QJsonValue *value, int depth)
+    {
+        if (depth > MAX_DEPTH || m_pos >= m_data.size()) return false;
+
+        switch (quint8(m_data[m_pos++])) {
+        case TAG_NULL:
+            *value = QJsonValue(QJsonValue::Null);
+            return true;
+        case TAG_FALSE:
+            *value = false;
+            return true;
+        case TAG_TRUE:
+            *value = true;
+            return true;
+        case TAG_INT: {
+            quint64 v;
+            if (!readVarint(&v)) return false;
+            *value = double(qint64(v >> 1) ^ -qint64(v & 1));
+            return true;
+        }
+        case TAG_DOUBLE: {
+            QByteArrayView bytes;
+            if (!readBytes(8, &bytes)) return false;
+            double d;
+            std::memcpy(&d, bytes.data(), sizeof(d));
+            *value = d;
+            return true;
+        }
+        case TAG_STRING: {
+            quint64 size;
+            QByteArrayView utf8;
+            if (!readVarint(&size) || !readBytes(size, &utf8)) return false;
+            *value = QString::fromUtf8(utf8);
+            return true;
+        }
+        case TAG_BYTES: {
+            quint64 size;
+            QByteArrayView bytes;
+            if (!readVarint(&size) || !readBytes(size, &bytes)) return false;
+            *value = QString::fromLatin1(bytes.toByteArray().toHex());
+            return true;
+        }
+        case TAG_ARRAY: {
+            quint64 count;
+            if (!readVarint(&count) || count > quint64(m_data.size())) return false;
+            QJsonArray array;
+            for (quint64 i = 0; i < count; ++i) {
+                QJsonValue element;
+                if (!readValue(&element, depth + 1)) return false;
+                array.append(element);
+            }
+            *value = array;
+            return true;
+        }
+        case TAG_OBJECT: {
+            QJsonObject object;
+            if (!readObject(&object, depth + 1)) return false;
+            *value = object;
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+private:
+    QByteArrayView m_data;
+    qsizetype m_pos = 0;
+};
+
+} // namespace
+
+namespace ControlCodec {
+
+QByteArray encode(const QJsonObject &message)
+{
+    QByteArray out;
+    out.reserve(64);
+    writeName(&out, MESSAGE_TYPES, message.value("type").toString());
+    writeObject(&out, message, true);
+    return out;
+}
+
+bool decode(QByteArrayView data, QJsonObject *message)
+{
+    Reader reader(data);
+    QString type;
+    QJsonObject object;
+    if (!reader.readName(MESSAGE_TYPES, &type) || !reader.readObject(&object, 0) || !reader.atEnd()) {
+        return false;
+    }
+    object.insert("type", type);
+    *message = object;
+    return true;
+}
+
+} // namespace ControlCodec
@@ -0,0 +1,37 @@
+#ifndef CONTROLCODEC_H
+#define CONTROLCODEC_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+
+/**
+ * @brief 控制消息的紧凑二进制编码
+ *
+ * 与JSON消息一一对应 (同样的 type 和字段)，登录时以 "encoding": "binary" 协商启用。
+ * 启用后每帧的内容为: 1字节标志 (FLAG_ENCRYPTED) + 消息体，
+ * 加密时消息体为AES-256-CBC密文，不再经过Base64。
+ *
+ * 消息体格式:
+ *   消息类型   varint: 已知类型为 (下标 << 1) | 1，否则为 (长度 << 1) 后跟UTF-8类型名
+ *   字段数     varint
+ *   每个字段   键 (与消息类型相同的表示方式，使用字段名表) + 值
+ *
+ * 值以1字节标签开头: null、false、true、整数 (zigzag varint)、double (8字节)、
+ * 字符串 (varint长度 + UTF-8)、数组 (varint个数 + 值)、对象 (varint个数 + 键值)、
+ * 字节串 (varint长度 + 原始字节)。
+ * 密钥字段 (session_key、channel_key) 在JSON中是十六进制字符串，二进制编码中以字节串存放，
+ * 解码时还原为同样的小写十六进制字符串，调用者看到的消息与JSON编码相同。
+ *
+ * 已知类型表和字段名表只能在末尾追加，否则新旧版本之间无法互通。
+ */
+namespace ControlCodec {
+
+constexpr quint8 FLAG_ENCRYPTED = 0x01;
+
+QByteArray encode(const QJsonObject &message);
+bool decode(QByteArrayView data, QJsonObject *message);
+
+} // namespace ControlCodec
+
+#endif // CONTROLCODEC_H
@@ -5,6 +5,7 @@
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/err.h>
+#include <cstring>
 
 QByteArray CryptoUtils::hashPassword(const QString &password)
 {
@@ -38,169 +39,292 @@ QByteArray CryptoUtils::generateAESKey()
     return key;
 }
 
-QByteArray CryptoUtils::encryptAES_CBC(const QByteArray &plaintext, const QByteArray &key)
+AesContext::AesContext(const QByteArray &key)
+{
+    setKey(key);
+}
+
+AesContext::~AesContext()
 {
+    clear();
+}
+
+bool AesContext::setKey(const QByteArray &key)
+{
+    clear();
     if (key.size() != 32) {
         qWarning() << "Invalid key size for AES-256";
-        return QByteArray();
+        return false;
     }
+    m_key = key;
+    return true;
+}
 
-    // 生成随机IV
-    unsigned char iv[16];
-    if (RAND_bytes(iv, 16) != 1) {
-        qWarning() << "Failed to generate IV";
-        return QByteArray();
+void AesContext::clear()
+{
+    for (EVP_CIPHER_CTX *&ctx : m_contexts) {
+        EVP_CIPHER_CTX_free(ctx);
+        ctx = nullptr;
+    }
+    m_key.clear();
+}
+
+EVP_CIPHER_CTX *AesContext::context(Slot slot)
+{
+    if (m_contexts[slot] || m_key.isEmpty()) {
+        return m_contexts[slot];
     }
 
     EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
     if (!ctx) {
         qWarning() << "Failed to create cipher context";
-        return QByteArray();
+        return nullptr;
+    }
+
+    // 只设置密钥 (完成密钥展开)，IV在每次调用时设置
+    const unsigned char *key = reinterpret_cast<const unsigned char*>(m_key.constData());
+    int ok = 0;
+    switch (slot) {
+    case SLOT_CTR:
+        ok = EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), nullptr, key, nullptr);
+        break;
+    case SLOT_CBC_ENCRYPT:
+        ok = EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, nullptr);
+        break;
+    case SLOT_CBC_DECRYPT:
+        ok = EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, nullptr);
+        break;
+    case SLOT_GCM_ENCRYPT:
+        ok = EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, nullptr);
+        break;
+    case SLOT_GCM_DECRYPT:
+        ok = EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, nullptr);
+        break;
+    case SLOT_COUNT:
+        break;
+    }
+    if (ok != 1) {
+        qWarning() << "Failed to initialize cipher context";
+        EVP_CIPHER_CTX_free(ctx);
+        return nullptr;
+    }
+
+    m_contexts[slot] = ctx;
+    return ctx;
+}
+
+bool AesContext::cryptCTR(const char *in, char *out, qsizetype size, quint64 counter)
+{
+    EVP_CIPHER_CTX *ctx = context(SLOT_CTR);
+    if (!ctx) {
+        return false;
+    }
+
+    // 构造CTR模式的IV (nonce + counter)
+    unsigned char iv[16] = {0};
+    for (int i = 0; i < 8; ++i) {
+        iv[i] = (counter >> (56 - i * 8)) & 0xFF;
     }
 
-    QByteArray result;
+    // CTR模式不需要padding，重设IV即重置计数器状态
     int len = 0;
-    int ciphertext_len = 0;
+    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1
+        || EVP_EncryptUpdate(ctx, reinterpret_cast<unsigned char*>(out), &len,
+                             reinterpret_cast<const unsigned char*>(in), int(size)) != 1) {
+        qWarning() << "CTR encryption failed";
+        return false;
+    }
+    return true;
+}
 
-    // 初始化加密
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, 
-                          reinterpret_cast<const unsigned char*>(key.data()), iv) != 1) {
-        qWarning() << "Failed to initialize encryption";
-        EVP_CIPHER_CTX_free(ctx);
+QByteArray AesContext::cryptCTR(const QByteArray &data, quint64 counter)
+{
+    QByteArray result(data.size(), Qt::Uninitialized);
+    if (!cryptCTR(data.constData(), result.data(), data.size(), counter)) {
+        return QByteArray();
+    }
+    return result;
+}
+
+QByteArray AesContext::encryptCBC(const QByteArray &plaintext, const unsigned char *iv)
+{
+    EVP_CIPHER_CTX *ctx = context(SLOT_CBC_ENCRYPT);
+    if (!ctx) {
         return QByteArray();
     }
 
-    // 分配输出缓冲区 (明文长度 + 块大小)
-    QByteArray ciphertext(plaintext.size() + EVP_CIPHER_block_size(EVP_aes_256_cbc()), Qt::Uninitialized);
+    // IV和密文直接写入同一个缓冲区 (明文长度 + 块大小)
+    const int blockSize = EVP_CIPHER_block_size(EVP_aes_256_cbc());
+    QByteArray result(16 + plaintext.size() + blockSize, Qt::Uninitialized);
+    unsigned char *resultIv = reinterpret_cast<unsigned char*>(result.data());
+    if (iv) {
+        std::memcpy(resultIv, iv, 16);
+    } else if (RAND_bytes(resultIv, 16) != 1) {
+        qWarning() << "Failed to generate IV";
+        return QByteArray();
+    }
+    unsigned char *ciphertext = resultIv + 16;
 
-    // 加密数据
-    if (EVP_EncryptUpdate(ctx, reinterpret_cast<unsigned char*>(ciphertext.data()), &len,
-                         reinterpret_cast<const unsigned char*>(plaintext.data()), 
-                         plaintext.size()) != 1) {
+    int len = 0;
+    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, resultIv) != 1
+        || EVP_EncryptUpdate(ctx, ciphertext, &len,
+                             reinterpret_cast<const unsigned char*>(plaintext.constData()),
+                             plaintext.size()) != 1) {
         qWarning() << "Encryption failed";
-        EVP_CIPHER_CTX_free(ctx);
         return QByteArray();
     }
-    ciphertext_len = len;
+    int ciphertext_len = len;
 
     // 完成加密
-    if (EVP_EncryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(ciphertext.data()) + len, &len) != 1) {
+    if (EVP_EncryptFinal_ex(ctx, ciphertext + len, &len) != 1) {
         qWarning() << "Encryption finalization failed";
-        EVP_CIPHER_CTX_free(ctx);
         return QByteArray();
     }
     ciphertext_len += len;
-    ciphertext.resize(ciphertext_len);
-
-    EVP_CIPHER_CTX_free(ctx);
-
-    // 将IV添加到密文前面
-    result.append(reinterpret_cast<const char*>(iv), 16);
-    result.append(ciphertext);
-
+    result.resize(16 + ciphertext_len);
     return result;
 }
 
-QByteArray CryptoUtils::decryptAES_CBC(const QByteArray &ciphertext, const QByteArray &key)
+QByteArray AesContext::decryptCBC(const QByteArray &ciphertext)
 {
-    if (key.size() != 32) {
-        qWarning() << "Invalid key size for AES-256";
-        return QByteArray();
-    }
-
     if (ciphertext.size() < 16) {
         qWarning() << "Ciphertext too short";
         return QByteArray();
     }
 
-    // 提取IV
-    const unsigned char *iv = reinterpret_cast<const unsigned char*>(ciphertext.data());
-    QByteArray encrypted = ciphertext.mid(16);
-
-    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    EVP_CIPHER_CTX *ctx = context(SLOT_CBC_DECRYPT);
     if (!ctx) {
-        qWarning() << "Failed to create cipher context";
         return QByteArray();
     }
 
-    QByteArray plaintext(encrypted.size(), Qt::Uninitialized);
-    int len = 0;
-    int plaintext_len = 0;
+    // 前16字节为IV
+    const unsigned char *iv = reinterpret_cast<const unsigned char*>(ciphertext.constData());
+    const int encryptedSize = ciphertext.size() - 16;
 
-    // 初始化解密
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr,
-                          reinterpret_cast<const unsigned char*>(key.data()), iv) != 1) {
-        qWarning() << "Failed to initialize decryption";
-        EVP_CIPHER_CTX_free(ctx);
-        return QByteArray();
-    }
-
-    // 解密数据
-    if (EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char*>(plaintext.data()), &len,
-                         reinterpret_cast<const unsigned char*>(encrypted.data()),
-                         encrypted.size()) != 1) {
+    QByteArray plaintext(encryptedSize, Qt::Uninitialized);
+    int len = 0;
+    if (EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1
+        || EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char*>(plaintext.data()), &len,
+                             iv + 16, encryptedSize) != 1) {
         qWarning() << "Decryption failed";
-        EVP_CIPHER_CTX_free(ctx);
         return QByteArray();
     }
-    plaintext_len = len;
+    int plaintext_len = len;
 
     // 完成解密
     if (EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(plaintext.data()) + len, &len) != 1) {
         qWarning() << "Decryption finalization failed";
-        EVP_CIPHER_CTX_free(ctx);
         return QByteArray();
     }
     plaintext_len += len;
     plaintext.resize(plaintext_len);
-
-    EVP_CIPHER_CTX_free(ctx);
-
     return plaintext;
 }
 
-QByteArray CryptoUtils::encryptAES_CTR(const QByteArray &plaintext, const QByteArray &key, quint64 counter)
+// GCM使用默认的12字节IV: nonce (大端序) + 4个零字节
+static void gcmIv(unsigned char *iv, quint64 nonce)
 {
-    if (key.size() != 32) {
-        qWarning() << "Invalid key size for AES-256";
-        return QByteArray();
+    for (int i = 0; i < 8; ++i) {
+        iv[i] = (nonce >> (56 - i * 8)) & 0xFF;
     }
+    std::memset(iv + 8, 0, 4);
+}
 
-    // 构造CTR模式的IV (nonce + counter)
-    unsigned char iv[16] = {0};
-    // 使用counter作为nonce
-    for (int i = 0; i < 8; ++i) {
-        iv[i] = (counter >> (56 - i * 8)) & 0xFF;
+bool AesContext::sealGCM(char *data, qsizetype size, QByteArrayView aad, quint64 nonce, char *tag)
+{
+    EVP_CIPHER_CTX *ctx = context(SLOT_GCM_ENCRYPT);
+    if (!ctx) {
+        return false;
     }
 
-    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    unsigned char iv[12];
+    gcmIv(iv, nonce);
+    unsigned char *bytes = reinterpret_cast<unsigned char*>(data);
+    int len = 0;
+    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1
+        || (!aad.isEmpty() && EVP_EncryptUpdate(ctx, nullptr, &len,
+                                                reinterpret_cast<const unsigned char*>(aad.data()),
+                                                int(aad.size())) != 1)
+        || EVP_EncryptUpdate(ctx, bytes, &len, bytes, int(size)) != 1
+        || EVP_EncryptFinal_ex(ctx, bytes + len, &len) != 1
+        || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE, tag) != 1) {
+        qWarning() << "GCM encryption failed";
+        return false;
+    }
+    return true;
+}
+
+bool AesContext::openGCM(char *data, qsizetype size, QByteArrayView aad, quint64 nonce, const char *tag)
+{
+    EVP_CIPHER_CTX *ctx = context(SLOT_GCM_DECRYPT);
     if (!ctx) {
-        qWarning() << "Failed to create cipher context";
-        return QByteArray();
+        return false;
     }
 
-    QByteArray ciphertext(plaintext.size(), Qt::Uninitialized);
+    unsigned char iv[12];
+    gcmIv(iv, nonce);
+    unsigned char *bytes = reinterpret_cast<unsigned char*>(data);
     int len = 0;
+    if (EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1
+        || (!aad.isEmpty() && EVP_DecryptUpdate(ctx, nullptr, &len,
+                                                reinterpret_cast<const unsigned char*>(aad.data()),
+                                                int(aad.size())) != 1)
+        || EVP_DecryptUpdate(ctx, bytes, &len, bytes, int(size)) != 1
+        || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE, const_cast<char*>(tag)) != 1) {
+        return false;
+    }
 
-    // CTR模式不需要padding
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), nullptr,
-                          reinterpret_cast<const unsigned char*>(key.data()), iv) != 1) {
-        qWarning() << "Failed to initialize CTR encryption";
-        EVP_CIPHER_CTX_free(ctx);
+    // 标签校验失败是网络上的正常情况 (损坏或伪造的数据包)，由调用者丢弃，不输出警告
+    return EVP_DecryptFinal_ex(ctx, bytes + len, &len) == 1;
+}
+
+QByteArray CryptoUtils::encryptAES_CBC(const QByteArray &plaintext, const QByteArray &key)
+{
+    AesContext context;
+    if (!context.setKey(key)) {
         return QByteArray();
     }
+    return context.encryptCBC(plaintext);
+}
 
-    if (EVP_EncryptUpdate(ctx, reinterpret_cast<unsigned char*>(ciphertext.data()), &len,
-                         reinterpret_cast<const unsigned char*>(plaintext.data()),
-                         plaintext.size()) != 1) {
-        qWarning() << "CTR encryption failed";
-        EVP_CIPHER_CTX_free(ctx);
-        return QByteArray();
+QVector<QByteArray> CryptoUtils::encryptAES_CBC(const QByteArray &plaintext, const QVector<AesContext*> &contexts)
+{
+    QVector<QByteArray> results(contexts.size());
+    if (contexts.isEmpty()) {
+        return results;
     }
 
-    EVP_CIPHER_CTX_free(ctx);
+    // 一次生成所有接收者的IV
+    QByteArray ivs(contexts.size() * 16, Qt::Uninitialized);
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(ivs.data()), ivs.size()) != 1) {
+        qWarning() << "Failed to generate IV";
+        return results;
+    }
+
+    // 每个接收者的上下文已完成密钥展开，这里只重设IV
+    for (int i = 0; i < contexts.size(); ++i) {
+        const unsigned char *iv = reinterpret_cast<const unsigned char*>(ivs.constData()) + i * 16;
+        results[i] = contexts.at(i)->encryptCBC(plaintext, iv);
+    }
+    return results;
+}
 
-    return ciphertext;
+QByteArray CryptoUtils::decryptAES_CBC(const QByteArray &ciphertext, const QByteArray &key)
+{
+    AesContext context;
+    if (!context.setKey(key)) {
+        return QByteArray();
+    }
+    return context.decryptCBC(ciphertext);
+}
+
+QByteArray CryptoUtils::encryptAES_CTR(const QByteArray &plaintext, const QByteArray &key, quint64 counter)
+{
+    AesContext context;
+    if (!context.setKey(key)) {
+        return QByteArray();
+    }
+    return context.cryptCTR(plaintext, counter);
 }
 
 QByteArray CryptoUtils::decryptAES_CTR(const QByteArray &ciphertext, const QByteArray &key, quint64 counter)
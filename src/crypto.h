@@ -3,6 +3,63 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
+
+struct evp_cipher_ctx_st;
+
+/**
+ * @brief 已设置密钥的AES-256上下文
+ *
+ * 每种用法 (CTR、CBC加密/解密、GCM加密/解密) 的EVP上下文在首次使用时创建并完成密钥展开，
+ * 之后每次调用只重设IV/计数器，不再分配上下文或重新展开密钥。
+ * 用于同一密钥的高频调用 (每个语音帧、每条控制消息)。不可复制，也不是线程安全的。
+ */
+class AesContext
+{
+public:
+    AesContext() = default;
+    explicit AesContext(const QByteArray &key);
+    ~AesContext();
+
+    AesContext(const AesContext &) = delete;
+    AesContext &operator=(const AesContext &) = delete;
+
+    // 密钥不是32字节时返回false，上下文变为无效
+    bool setKey(const QByteArray &key);
+    void clear();
+    bool isValid() const { return !m_key.isEmpty(); }
+    const QByteArray &key() const { return m_key; }
+
+    // AES-256-CTR，计数器放在IV的高8字节 (与 CryptoUtils::encryptAES_CTR 相同)，允许原地处理
+    bool cryptCTR(const char *in, char *out, qsizetype size, quint64 counter);
+    QByteArray cryptCTR(const QByteArray &data, quint64 counter);
+
+    // AES-256-CBC，格式为 [IV][密文] (与 CryptoUtils::encryptAES_CBC 相同)，iv 为空时随机生成
+    QByteArray encryptCBC(const QByteArray &plaintext, const unsigned char *iv = nullptr);
+    QByteArray decryptCBC(const QByteArray &ciphertext);
+
+    // AES-256-GCM，在调用者的缓冲区内原地加密/解密，不分配内存
+    // aad 只认证不加密 (语音数据包头部)；nonce 放在12字节IV的高8字节
+    static constexpr int GCM_TAG_SIZE = 16;
+    bool sealGCM(char *data, qsizetype size, QByteArrayView aad, quint64 nonce, char *tag);
+    // 标签不符 (数据损坏、被篡改或密钥不同) 时返回false，此时 data 的内容无效
+    bool openGCM(char *data, qsizetype size, QByteArrayView aad, quint64 nonce, const char *tag);
+
+private:
+    enum Slot {
+        SLOT_CTR,
+        SLOT_CBC_ENCRYPT,
+        SLOT_CBC_DECRYPT,
+        SLOT_GCM_ENCRYPT,
+        SLOT_GCM_DECRYPT,
+        SLOT_COUNT
+    };
+    evp_cipher_ctx_st *context(Slot slot);
+
+    QByteArray m_key;
+    evp_cipher_ctx_st *m_contexts[SLOT_COUNT] = {};
+};
 
 class CryptoUtils
 {
@@ -19,8 +76,13 @@ public:
     // AES-256-CBC 加密/解密 (用于TCP消息)
     static QByteArray encryptAES_CBC(const QByteArray &plaintext, const QByteArray &key);
     static QByteArray decryptAES_CBC(const QByteArray &ciphertext, const QByteArray &key);
+
+    // 用多个接收者的上下文分别加密同一明文 (广播)，一次生成所有IV
+    // 结果与 contexts 一一对应，格式与单个加密相同，失败的项为空
+    static QVector<QByteArray> encryptAES_CBC(const QByteArray &plaintext, const QVector<AesContext*> &contexts);
     
     // AES-256-CTR 加密/解密 (用于UDP音频)
+    // 以下单次调用的函数每次都创建上下文，同一密钥反复使用时应持有 AesContext
     static QByteArray encryptAES_CTR(const QByteArray &plaintext, const QByteArray &key, quint64 counter);
     static QByteArray decryptAES_CTR(const QByteArray &ciphertext, const QByteArray &key, quint64 counter);
     
@@ -0,0 +1,84 @@
+#include "frameparser.h"
+#include <cstring>
+
+void FrameParser::append(const char *data, qsizetype size)
+{
+    if (m_error || size <= 0) return;
+
+    // 丢弃已消费的部分，剩余的不完整帧前移 (每次读取最多一次)
+    if (m_offset > 0) {
+        m_buffer.remove(0, m_offset);
+        m_scanned -= m_offset;
+        m_offset = 0;
+    }
+    m_buffer.append(data, size);
+
+    if (m_mode == Mode::Detect) {
+        m_mode = m_buffer.at(0) == '{' ? Mode::Newline : Mode::LengthPrefixed;
+    }
+}
+
+bool FrameParser::next(QByteArrayView *frame)
+{
+    if (m_error) return false;
+
+    const char *data = m_buffer.constData();
+    qsizetype available = m_buffer.size() - m_offset;
+
+    if (m_mode == Mode::Newline) {
+        qsizetype from = qMax(m_scanned, m_offset);
+        const void *newline = std::memchr(data + from, '\n', size_t(m_buffer.size() - from));
+        if (!newline) {
+            m_scanned = m_buffer.size();
+            if (m_buffer.size() - m_offset > qsizetype(MAX_FRAME_SIZE)) m_error = true;
+            return false;
+        }
+
+        qsizetype end = static_cast<const char *>(newline) - data;
+        *frame = QByteArrayView(data + m_offset, end - m_offset);
+        m_offset = end + 1;
+        m_scanned = m_offset;
+        return true;
+    }
+
+    if (available < LENGTH_SIZE) return false;
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data + m_offset);
+    quint32 length = (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+    if (length > MAX_FRAME_SIZE) {
+        m_error = true;
+        return false;
+    }
+    if (available - LENGTH_SIZE < qsizetype(length)) {
+        // 提前预留整帧的空间，避免大消息分多次到达时反复扩容
+        m_buffer.reserve(m_offset + LENGTH_SIZE + qsizetype(length));
+        return false;
+    }
+
+    *frame = QByteArrayView(data + m_offset + LENGTH_SIZE, qsizetype(length));
+    m_offset += LENGTH_SIZE + qsizetype(length);
+    return true;
+}
+
+void FrameParser::appendFrame(QByteArray *out, QByteArrayView payload, Mode mode)
+{
+    if (mode == Mode::LengthPrefixed) {
+        quint32 length = quint32(payload.size());
+        char prefix[LENGTH_SIZE] = {
+            char(length >> 24), char(length >> 16), char(length >> 8), char(length)
+        };
+        out->append(prefix, LENGTH_SIZE);
+        out->append(payload.data(), payload.size());
+    } else {
+        out->append(payload.data(), payload.size());
+        out->append('\n');
+    }
+}
+
+QByteArray FrameParser::frame(QByteArrayView payload, Mode mode)
+{
+    QByteArray out;
+    out.reserve(payload.size() + LENGTH_SIZE);
+    appendFrame(&out, payload, mode);
+    return out;
+}
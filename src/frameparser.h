@@ -0,0 +1,55 @@
+#ifndef FRAMEPARSER_H
+#define FRAMEPARSER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+/**
+ * @brief 控制连接的增量帧解析器
+ *
+ * 帧格式: 4字节大端序长度 + 消息内容。
+ * 为兼容旧客户端，Detect 模式根据连接的第一个字节判断:
+ * 旧客户端总是以明文JSON ('{') 开始并以换行符分隔消息，此时切换为 Newline 模式。
+ *
+ * 每次读到的数据追加到同一个缓冲区，已解析的位置用偏移量记录，
+ * 不会重新扫描已检查过的字节；next() 返回的帧直接指向缓冲区，不复制。
+ * 未消费的剩余数据只在下一次 append() 时前移一次。
+ */
+class FrameParser
+{
+public:
+    enum class Mode {
+        Detect,         // 由第一个字节决定 (服务器端)
+        LengthPrefixed,
+        Newline         // 旧协议: 以 '\n' 分隔
+    };
+
+    static constexpr int LENGTH_SIZE = 4;
+    static constexpr quint32 MAX_FRAME_SIZE = 1024 * 1024;
+
+    explicit FrameParser(Mode mode = Mode::Detect) : m_mode(mode) {}
+
+    void append(const char *data, qsizetype size);
+    void append(const QByteArray &data) { append(data.constData(), data.size()); }
+
+    // 取出下一个完整帧; 数据不足或出错时返回false
+    // 返回的视图在下一次调用 append() / next() 之前有效
+    bool next(QByteArrayView *frame);
+
+    // 帧长度超过上限时置位，之后不再产生帧，调用者应断开连接
+    bool hasError() const { return m_error; }
+    Mode mode() const { return m_mode; }
+
+    // 按指定模式封装一条消息 (Detect 尚未确定时按旧协议处理)
+    static void appendFrame(QByteArray *out, QByteArrayView payload, Mode mode);
+    static QByteArray frame(QByteArrayView payload, Mode mode);
+
+private:
+    QByteArray m_buffer;
+    qsizetype m_offset = 0;  // 下一帧的起始位置
+    qsizetype m_scanned = 0; // Newline 模式: 已确认不含换行符的位置
+    Mode m_mode;
+    bool m_error = false;
+};
+
+#endif // FRAMEPARSER_H
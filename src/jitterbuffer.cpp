@@ -0,0 +1,159 @@
+#include "jitterbuffer.h"
+#include <cmath>
+#include <cstring>
+
+JitterBuffer::JitterBuffer(int frameSamples, int sampleRate)
+    : m_frameSamples(frameSamples)
+    , m_sampleRate(sampleRate)
+    , m_slots(CAPACITY)
+{
+}
+
+void JitterBuffer::reset()
+{
+    for (Slot &s : m_slots) {
+        s.filled = false;
+    }
+    m_count = 0;
+    m_playing = false;
+    m_anchored = false;
+    m_ended = false;
+    m_waitTicks = 0;
+    m_concealed = 0;
+    m_hasTransit = false;
+}
+
+void JitterBuffer::updateJitter(quint32 timestamp, qint64 arrivalMs)
+{
+    // 到达时刻换算为媒体时钟的采样数；传输时间的绝对值没有意义，只比较相邻两包的差
+    const quint32 arrival = quint32(arrivalMs * m_sampleRate / 1000);
+    const quint32 transit = arrival - timestamp;
+    if (m_hasTransit) {
+        const qint32 d = qint32(transit - m_lastTransit);
+        m_jitter += (std::abs(double(d)) - m_jitter) / 16.0;
+    }
+    m_lastTransit = transit;
+    m_hasTransit = true;
+
+    // 目标深度覆盖约3倍的平均抖动，另加正在播放的一帧
+    const int frames = int(std::ceil(3.0 * m_jitter / m_frameSamples));
+    m_target = qBound(MIN_DEPTH, 1 + frames, MAX_DEPTH);
+}
+
+void JitterBuffer::push(quint32 sequence, quint32 timestamp, bool marker, const char *payload, qsizetype size,
+                        qint64 arrivalMs)
+{
+    m_stats.received++;
+    if (size <= 0 || size > MAX_PAYLOAD) return;
+    m_ended = false;
+
+    if (m_anchored) {
+        const qint32 offset = qint32(sequence - m_next);
+        if (offset <= -CAPACITY || (m_playing && offset >= CAPACITY)) {
+            // 序号跳变: 发送方重新开始 (重启音频引擎或重新登录)，丢弃旧状态重新缓冲
+            reset();
+        } else if (offset < 0) {
+            m_stats.late++;
+            return;
+        }
+    }
+    if (marker && m_playing && m_count == 0) {
+        // 新的一段发言: 之前的间隔是发送方停发 (静音或服务器切换混音)，不再补帧，按目标深度重新缓冲
+        m_playing = false;
+        m_waitTicks = 0;
+        m_concealed = 0;
+    }
+    if (!m_playing && m_count > 0 && qAbs(qint32(sequence - m_first)) >= CAPACITY) {
+        reset();
+    }
+
+    Slot &s = slot(sequence);
+    if (s.filled) {
+        if (s.sequence == sequence) {
+            m_stats.late++; // 重复的包
+            return;
+        }
+        // 缓冲窗口之外的旧数据，只在序号异常时出现
+        reset();
+    }
+
+    updateJitter(timestamp, arrivalMs);
+
+    s.sequence = sequence;
+    s.size = size;
+    s.filled = true;
+    std::memcpy(s.data, payload, size_t(size));
+    if (!m_playing && (m_count == 0 || qint32(sequence - m_first) < 0)) {
+        m_first = sequence;
+    }
+    m_count++;
+}
+
+JitterBuffer::Result JitterBuffer::pop(QByteArrayView *payload)
+{
+    if (!m_playing) {
+        if (m_count == 0) {
+            m_idleTicks++;
+            return Result::Empty;
+        }
+        m_idleTicks = 0;
+        // 缓冲达到目标深度，或最早的包已经等待了目标深度的时长，开始播放
+        if (m_count < m_target && ++m_waitTicks < m_target) {
+            return Result::Empty;
+        }
+        m_playing = true;
+        m_anchored = true;
+        m_next = m_first;
+        m_waitTicks = 0;
+        m_concealed = 0;
+    }
+    m_idleTicks = 0;
+
+    // 缓冲过深 (抖动减小或之前的突发)，每个周期丢弃一帧逐步降低延迟
+    if (m_count > m_target + DEPTH_HYSTERESIS) {
+        Slot &s = slot(m_next);
+        if (s.filled && s.sequence == m_next) {
+            s.filled = false;
+            m_count--;
+        }
+        m_stats.dropped++;
+        m_next++;
+    }
+
+    Slot &s = slot(m_next);
+    if (s.filled && s.sequence == m_next) {
+        s.filled = false;
+        m_count--;
+        m_next++;
+        m_concealed = 0;
+        m_stats.played++;
+        *payload = QByteArrayView(s.data, s.size);
+        return Result::Packet;
+    }
+
+    if (m_count == 0) {
+        if (m_ended || m_concealed >= MAX_CONCEALED) {
+            // 发言结束或长时间中断，保留播放位置以丢弃之后迟到的包
+            m_playing = false;
+            m_concealed = 0;
+            return Result::Empty;
+        }
+        m_concealed++;
+        m_stats.concealed++;
+        return Result::Missing;
+    }
+
+    m_next++;
+    m_concealed++;
+    m_stats.lost++;
+    return Result::Missing;
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const
+{
+    Stats stats = m_stats;
+    stats.depth = m_count;
+    stats.targetDepth = m_target;
+    stats.jitterMs = m_jitter * 1000.0 / m_sampleRate;
+    return stats;
+}
@@ -0,0 +1,101 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <QByteArrayView>
+#include <QVector>
+
+/**
+ * @brief 单个发言者的自适应抖动缓冲
+ *
+ * 数据包按头部序号放入环形槽位，播放时钟每帧取出一帧，乱序到达的包在此重新排序。
+ * 目标深度由到达抖动决定 (RFC 3550 的到达间隔抖动估计，按媒体时间戳与到达时刻计算):
+ * 网络平稳时只缓冲1帧，抖动增大时加深，缓冲超过目标深度时逐帧丢弃以降低延迟。
+ *
+ * 播放时刻缺失的帧返回 Missing，由调用者用Opus丢包隐藏 (PLC) 补出:
+ * 之后的包已经到达时视为丢包并跳过该帧；缓冲已空时视为延迟到达，
+ * 补帧但不前进播放位置，缓冲因此加深一帧。连续补帧超过上限后视为发言结束，重新缓冲。
+ * 发送方有意停发造成的间隔不补帧: 带发言开始标记的包到达时缓冲已空则直接重新缓冲，
+ * endStream 之后缓冲播放完即停止。
+ *
+ * 不是线程安全的，push 和 pop 应在同一线程调用。
+ */
+class JitterBuffer
+{
+public:
+    enum class Result {
+        Packet,  // 取出一帧，payload 指向缓冲区内的Opus数据
+        Missing, // 该帧缺失，应以PLC补帧
+        Empty    // 没有正在播放的流 (缓冲中或空闲)，不输出
+    };
+
+    struct Stats {
+        int depth = 0;          // 当前缓冲的帧数
+        int targetDepth = 0;    // 按抖动计算的目标帧数
+        double jitterMs = 0.0;  // 到达间隔抖动估计
+        quint64 received = 0;
+        quint64 played = 0;
+        quint64 late = 0;       // 播放位置之后到达或重复的包，直接丢弃
+        quint64 lost = 0;       // 播放时缺失且之后的包已到达，以PLC补出
+        quint64 concealed = 0;  // 缓冲耗尽时以PLC补出的帧 (等待延迟的包)
+        quint64 dropped = 0;    // 缓冲过深时为降低延迟丢弃的帧
+    };
+
+    static constexpr int CAPACITY = 64;        // 槽位数 (20ms帧时约1.3秒)
+    static constexpr int MAX_PAYLOAD = 1500;
+    static constexpr int MIN_DEPTH = 1;
+    static constexpr int MAX_DEPTH = 10;
+    static constexpr int DEPTH_HYSTERESIS = 2; // 超过目标深度这么多帧才开始丢帧
+    static constexpr int MAX_CONCEALED = 5;    // 连续补帧上限，之后停止播放并重新缓冲
+
+    explicit JitterBuffer(int frameSamples = 960, int sampleRate = 48000);
+
+    // 放入一个已解密的Opus负载；marker 为头部的发言开始标记，arrivalMs 为单调时钟上的到达时刻
+    void push(quint32 sequence, quint32 timestamp, bool marker, const char *payload, qsizetype size,
+              qint64 arrivalMs);
+
+    // 发送方已停止这一路 (例如服务器换了发给本客户端的混音流)，播放完已缓冲的帧后不再补帧
+    void endStream() { m_ended = true; }
+
+    // 每个播放周期调用一次; 返回 Packet 时 payload 在下一次 push 之前有效
+    Result pop(QByteArrayView *payload);
+
+    // 连续没有任何数据的播放周期数，调用者据此回收不再发言的缓冲
+    int idleTicks() const { return m_idleTicks; }
+
+    Stats stats() const;
+    void reset();
+
+private:
+    struct Slot {
+        quint32 sequence = 0;
+        bool filled = false;
+        qsizetype size = 0;
+        char data[MAX_PAYLOAD];
+    };
+
+    Slot &slot(quint32 sequence) { return m_slots[int(sequence % CAPACITY)]; }
+    void updateJitter(quint32 timestamp, qint64 arrivalMs);
+
+    const int m_frameSamples;
+    const int m_sampleRate;
+    QVector<Slot> m_slots;
+    int m_count = 0;           // 已缓冲的帧数
+    bool m_playing = false;
+    bool m_anchored = false;   // 已确定播放位置，之前的序号视为迟到
+    bool m_ended = false;      // endStream 之后没有新的包
+    quint32 m_next = 0;        // 下一个播放的序号
+    quint32 m_first = 0;       // 缓冲中 (未播放时) 最早的序号
+    int m_waitTicks = 0;       // 未达到目标深度时已等待的周期数
+    int m_concealed = 0;       // 连续补帧数
+    int m_idleTicks = 0;
+
+    // RFC 3550 抖动估计 (单位: 采样)
+    double m_jitter = 0.0;
+    quint32 m_lastTransit = 0;
+    bool m_hasTransit = false;
+    int m_target = MIN_DEPTH;
+
+    Stats m_stats;
+};
+
+#endif // JITTERBUFFER_H
@@ -10,7 +10,7 @@ OpusCodec::~OpusCodec()
     cleanup();
 }
 
-bool OpusCodec::initialize(int sampleRate, int channels, int bitrate)
+bool OpusCodec::initialize(int sampleRate, int channels, int bitrate, Mode mode)
 {
     cleanup();
     
@@ -30,13 +30,15 @@ bool OpusCodec::initialize(int sampleRate, int channels, int bitrate)
     opus_encoder_ctl(m_encoder, OPUS_SET_BITRATE(bitrate));
     
     // 创建解码器
-    m_decoder = opus_decoder_create(sampleRate, channels, &error);
-    if (error != OPUS_OK) {
-        m_lastError = QString("Failed to create Opus decoder: %1").arg(opus_strerror(error));
-        qWarning() << m_lastError;
-        opus_encoder_destroy(m_encoder);
-        m_encoder = nullptr;
-        return false;
+    if (mode == EncoderAndDecoder) {
+        m_decoder = opus_decoder_create(sampleRate, channels, &error);
+        if (error != OPUS_OK) {
+            m_lastError = QString("Failed to create Opus decoder: %1").arg(opus_strerror(error));
+            qWarning() << m_lastError;
+            opus_encoder_destroy(m_encoder);
+            m_encoder = nullptr;
+            return false;
+        }
     }
     
     m_initialized = true;
@@ -61,16 +63,11 @@ QByteArray OpusCodec::encode(const QByteArray &pcmData, int frameSize)
     }
     
     // 准备输出缓冲区 (最大4000字节对于大多数情况足够)
-    QByteArray encoded(4000, 0);
+    QByteArray encoded(4000, Qt::Uninitialized);
     
     const opus_int16 *pcm = reinterpret_cast<const opus_int16*>(pcmData.constData());
-    unsigned char *output = reinterpret_cast<unsigned char*>(encoded.data());
-    
-    int encodedBytes = opus_encode(m_encoder, pcm, frameSize, output, encoded.size());
-    
+    int encodedBytes = encode(pcm, frameSize, encoded.data(), encoded.size());
     if (encodedBytes < 0) {
-        m_lastError = QString("Encoding failed: %1").arg(opus_strerror(encodedBytes));
-        qWarning() << m_lastError;
         return QByteArray();
     }
     
@@ -78,6 +75,22 @@ QByteArray OpusCodec::encode(const QByteArray &pcmData, int frameSize)
     return encoded;
 }
 
+int OpusCodec::encode(const qint16 *pcm, int frameSize, char *output, int maxBytes)
+{
+    if (!m_initialized || !m_encoder) {
+        m_lastError = "Encoder not initialized";
+        return OPUS_INVALID_STATE;
+    }
+    
+    int encodedBytes = opus_encode(m_encoder, pcm, frameSize, reinterpret_cast<unsigned char*>(output), maxBytes);
+    
+    if (encodedBytes < 0) {
+        m_lastError = QString("Encoding failed: %1").arg(opus_strerror(encodedBytes));
+        qWarning() << m_lastError;
+    }
+    return encodedBytes;
+}
+
 QByteArray OpusCodec::decode(const QByteArray &opusData, int frameSize)
 {
     if (!m_initialized || !m_decoder) {
@@ -92,7 +105,7 @@ QByteArray OpusCodec::decode(const QByteArray &opusData, int frameSize)
     
     // 准备输出缓冲区
     int maxSamples = frameSize * m_channels;
-    QByteArray decoded(maxSamples * sizeof(opus_int16), 0);
+    QByteArray decoded(maxSamples * sizeof(opus_int16), Qt::Uninitialized);
     
     const unsigned char *input = reinterpret_cast<const unsigned char*>(opusData.constData());
     opus_int16 *output = reinterpret_cast<opus_int16*>(decoded.data());
@@ -127,3 +140,49 @@ void OpusCodec::cleanup()
     }
     m_initialized = false;
 }
+
+OpusDecoderPool::OpusDecoderPool(int sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(channels)
+{
+}
+
+OpusDecoderPool::~OpusDecoderPool()
+{
+    for (OpusDecoder *decoder : m_free) {
+        opus_decoder_destroy(decoder);
+    }
+}
+
+OpusDecoder *OpusDecoderPool::acquire()
+{
+    if (!m_free.isEmpty()) {
+        return m_free.takeLast();
+    }
+    
+    int error;
+    OpusDecoder *decoder = opus_decoder_create(m_sampleRate, m_channels, &error);
+    if (error != OPUS_OK) {
+        qWarning() << "Failed to create Opus decoder:" << opus_strerror(error);
+        return nullptr;
+    }
+    return decoder;
+}
+
+void OpusDecoderPool::release(OpusDecoder *decoder)
+{
+    if (!decoder) return;
+    // 清除上一个发言者的状态，下次取出时与新建的解码器相同
+    opus_decoder_ctl(decoder, OPUS_RESET_STATE);
+    m_free.append(decoder);
+}
+
+int OpusDecoderPool::decode(OpusDecoder *decoder, const char *data, qsizetype size, qint16 *pcm, int frameSize)
+{
+    const unsigned char *input = reinterpret_cast<const unsigned char*>(data);
+    int decodedSamples = opus_decode(decoder, input, data ? opus_int32(size) : 0, pcm, frameSize, 0);
+    if (decodedSamples < 0) {
+        qWarning() << "Decoding failed:" << opus_strerror(decodedSamples);
+    }
+    return decodedSamples;
+}
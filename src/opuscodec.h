@@ -3,6 +3,7 @@
 
 #include <QByteArray>
 #include <QString>
+#include <QVector>
 #include <opus/opus.h>
 
 /**
@@ -17,6 +18,11 @@
 class OpusCodec
 {
 public:
+    enum Mode {
+        EncoderAndDecoder,
+        EncoderOnly // 只编码 (客户端: 解码由每个发言者各自的解码器完成)
+    };
+
     OpusCodec();
     ~OpusCodec();
 
@@ -25,9 +31,11 @@ public:
      * @param sampleRate 采样率 (8000, 12000, 16000, 24000, 48000)
      * @param channels 声道数 (1 或 2)
      * @param bitrate 比特率 (bps), 推荐: 24000-64000
+     * @param mode EncoderOnly 时不创建解码器，decode 返回空
      * @return 成功返回true
      */
-    bool initialize(int sampleRate = 48000, int channels = 1, int bitrate = 24000);
+    bool initialize(int sampleRate = 48000, int channels = 1, int bitrate = 24000,
+                    Mode mode = EncoderAndDecoder);
 
     /**
      * @brief 编码PCM音频数据
@@ -37,6 +45,16 @@ public:
      */
     QByteArray encode(const QByteArray &pcmData, int frameSize = 960);
 
+    /**
+     * @brief 编码一帧PCM到调用者提供的缓冲区，不分配内存
+     * @param pcm PCM采样 (int16格式)，frameSize * channels 个
+     * @param frameSize 帧大小(采样数)
+     * @param output 输出缓冲区
+     * @param maxBytes 输出缓冲区大小，不超过1275字节的单帧Opus数据包总能放下
+     * @return 编码后的字节数，失败返回负的Opus错误码
+     */
+    int encode(const qint16 *pcm, int frameSize, char *output, int maxBytes);
+
     /**
      * @brief 解码Opus数据包
      * @param opusData Opus编码数据
@@ -74,4 +92,38 @@ private:
     void cleanup();
 };
 
+/**
+ * @brief Opus解码器状态池
+ *
+ * 每个远端发言者需要独立的解码器状态，交错解码不同发言者的数据包会互相破坏预测状态和PLC。
+ * 发言者离开时解码器重置后归还到池中，下一个发言者直接复用，不反复创建和销毁。
+ * 不是线程安全的。
+ */
+class OpusDecoderPool
+{
+public:
+    explicit OpusDecoderPool(int sampleRate = 48000, int channels = 1);
+    ~OpusDecoderPool();
+
+    // 取出一个处于初始状态的解码器，失败返回nullptr
+    OpusDecoder *acquire();
+    void release(OpusDecoder *decoder);
+
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+
+    /**
+     * @brief 解码一个数据包到调用者提供的缓冲区
+     * @param data Opus数据，为nullptr时做丢包隐藏 (PLC)
+     * @param pcm 输出缓冲区，至少 frameSize * channels 个采样
+     * @return 解码的采样数 (每声道)，失败返回负的Opus错误码
+     */
+    static int decode(OpusDecoder *decoder, const char *data, qsizetype size, qint16 *pcm, int frameSize);
+
+private:
+    const int m_sampleRate;
+    const int m_channels;
+    QVector<OpusDecoder*> m_free;
+};
+
 #endif // OPUSCODEC_H
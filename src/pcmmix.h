@@ -0,0 +1,51 @@
+#ifndef PCMMIX_H
+#define PCMMIX_H
+
+#include <QtGlobal>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PCMMIX_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PCMMIX_NEON
+#endif
+
+/**
+ * @brief int16 PCM混音工具
+ *
+ * 使用SIMD饱和加法 (SSE2 / NEON) 叠加音频帧，溢出时截断到int16范围而不是回绕。
+ * 不支持的平台使用标量实现。
+ */
+namespace PcmMix {
+
+// dst[i] = saturate(dst[i] + src[i])
+inline void addSaturate(qint16 *dst, const qint16 *src, int samples)
+{
+    int i = 0;
+#if defined(PCMMIX_SSE2)
+    for (; i + 8 <= samples; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_adds_epi16(a, b));
+    }
+#elif defined(PCMMIX_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+    }
+#endif
+    for (; i < samples; ++i) {
+        int sum = int(dst[i]) + int(src[i]);
+        dst[i] = qint16(qBound(-32768, sum, 32767));
+    }
+}
+
+inline void clear(qint16 *dst, int samples)
+{
+    std::memset(dst, 0, size_t(samples) * sizeof(qint16));
+}
+
+} // namespace PcmMix
+
+#endif // PCMMIX_H
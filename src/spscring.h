@@ -0,0 +1,99 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief 单生产者/单消费者无锁环形队列
+ *
+ * 容量固定 (向上取整为2的幂)，槽位在构造时一次分配。生产者只写 head，消费者只写 tail，
+ * 以 acquire/release 原子操作交接槽位，两端都不加锁、不阻塞、不分配内存，队列满或空时立即返回。
+ * 槽位可以原地填写和读取 (beginWrite/commitWrite, front/pop)，较大的元素不需要额外复制。
+ *
+ * 只能有一个线程写入、一个线程读取。
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(quint32 capacity)
+    {
+        m_capacity = 1;
+        while (m_capacity < capacity) {
+            m_capacity <<= 1;
+        }
+        m_mask = m_capacity - 1;
+        m_slots.reset(new T[m_capacity]);
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    quint32 capacity() const { return m_capacity; }
+
+    // 生产者: 返回下一个可写的槽位，队列已满时返回nullptr；填写后调用 commitWrite 发布
+    T *beginWrite()
+    {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail == m_capacity) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail == m_capacity) return nullptr;
+        }
+        return &m_slots[head & m_mask];
+    }
+
+    void commitWrite()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool push(const T &value)
+    {
+        T *slot = beginWrite();
+        if (!slot) return false;
+        *slot = value;
+        commitWrite();
+        return true;
+    }
+
+    // 消费者: 返回最早的元素，队列为空时返回nullptr；处理完后调用 pop 归还槽位
+    // 在 pop 之前槽位属于消费者，可以原地修改
+    T *front()
+    {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) return nullptr;
+        }
+        return &m_slots[tail & m_mask];
+    }
+
+    void pop()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool tryPop(T *value)
+    {
+        T *slot = front();
+        if (!slot) return false;
+        *value = *slot;
+        pop();
+        return true;
+    }
+
+private:
+    std::unique_ptr<T[]> m_slots;
+    quint32 m_capacity = 0;
+    quint32 m_mask = 0;
+
+    // 生产者和消费者的索引放在不同的缓存行，各自缓存对方的索引以减少跨核读取
+    alignas(64) std::atomic<quint32> m_head{0};
+    quint32 m_cachedTail = 0;
+    alignas(64) std::atomic<quint32> m_tail{0};
+    quint32 m_cachedHead = 0;
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,139 @@
+#ifndef VOICEPACKET_H
+#define VOICEPACKET_H
+
+#include <QtGlobal>
+#include <cmath>
+
+/**
+ * @brief UDP语音数据包头部 (版本2，12字节)
+ *
+ * 格式 (头部不加密，服务器可读取，多字节字段均为大端序):
+ *   [0]      高2位: 版本 (2)，低6位: 标志
+ *   [1]      音频电平 (RFC 6464: -dBov, 0 = 最响, 127 = 静音)
+ *   [2..3]   发送者ID (登录时由服务器分配；服务器混音的每一路输出也各有一个ID，0 保留)
+ *   [4..7]   序号 (每包加1，起始值随机)
+ *   [8..11]  媒体时间戳 (48kHz采样数，每帧加960，起始值随机)
+ *   [12..]   Opus数据
+ *
+ * 有频道密钥时Opus数据为AES-256-GCM密文，其后是16字节认证标签；头部作为附加数据一起认证，
+ * nonce由头部字段导出。接收方在解码前校验标签，损坏或伪造的数据包直接丢弃。
+ * 版本1使用未认证的AES-256-CTR，已不再接受。
+ */
+namespace VoicePacket {
+
+constexpr quint8 VERSION = 2;
+constexpr int HEADER_SIZE = 12;
+constexpr int TAG_SIZE = 16; // 加密时负载末尾的GCM认证标签
+
+constexpr int FLAGS_OFFSET = 0;
+constexpr int LEVEL_OFFSET = 1;
+constexpr int SENDER_OFFSET = 2;
+constexpr int SEQUENCE_OFFSET = 4;
+constexpr int TIMESTAMP_OFFSET = 8;
+
+constexpr quint8 FLAG_MARKER = 0x01; // 一段发言的第一个包 (开始发送或静音之后)
+constexpr quint8 FLAG_MIXED = 0x02;  // 服务器生成的混音 (每个客户端同一时刻只收到一路)
+constexpr quint8 FLAGS_MASK = 0x3F;
+
+constexpr quint16 SERVER_SENDER_ID = 0;
+constexpr quint8 LEVEL_SILENT = 127;
+
+struct Header {
+    quint8 flags = 0;
+    quint8 level = LEVEL_SILENT;
+    quint16 senderId = 0;
+    quint32 sequence = 0;
+    quint32 timestamp = 0;
+};
+
+inline void writeU16(char *p, quint16 v)
+{
+    p[0] = char(v >> 8);
+    p[1] = char(v);
+}
+
+inline void writeU32(char *p, quint32 v)
+{
+    p[0] = char(v >> 24);
+    p[1] = char(v >> 16);
+    p[2] = char(v >> 8);
+    p[3] = char(v);
+}
+
+inline quint16 readU16(const char *p)
+{
+    const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+    return quint16((u[0] << 8) | u[1]);
+}
+
+inline quint32 readU32(const char *p)
+{
+    const unsigned char *u = reinterpret_cast<const unsigned char *>(p);
+    return (quint32(u[0]) << 24) | (quint32(u[1]) << 16) | (quint32(u[2]) << 8) | quint32(u[3]);
+}
+
+inline void writeHeader(char *packet, const Header &header)
+{
+    packet[FLAGS_OFFSET] = char((VERSION << 6) | (header.flags & FLAGS_MASK));
+    packet[LEVEL_OFFSET] = char(header.level & 0x7F);
+    writeU16(packet + SENDER_OFFSET, header.senderId);
+    writeU32(packet + SEQUENCE_OFFSET, header.sequence);
+    writeU32(packet + TIMESTAMP_OFFSET, header.timestamp);
+}
+
+// 长度和版本检查，不读取其余字段
+inline bool isValid(const char *packet, qsizetype size)
+{
+    return size >= HEADER_SIZE && (static_cast<unsigned char>(packet[FLAGS_OFFSET]) >> 6) == VERSION;
+}
+
+inline bool readHeader(const char *packet, qsizetype size, Header *header)
+{
+    if (!isValid(packet, size)) return false;
+    header->flags = quint8(packet[FLAGS_OFFSET]) & FLAGS_MASK;
+    header->level = quint8(packet[LEVEL_OFFSET]) & 0x7F;
+    header->senderId = readU16(packet + SENDER_OFFSET);
+    header->sequence = readU32(packet + SEQUENCE_OFFSET);
+    header->timestamp = readU32(packet + TIMESTAMP_OFFSET);
+    return true;
+}
+
+inline quint8 readLevel(const char *packet)
+{
+    return quint8(static_cast<unsigned char>(packet[LEVEL_OFFSET]) & 0x7F);
+}
+
+inline quint16 readSenderId(const char *packet)
+{
+    return readU16(packet + SENDER_OFFSET);
+}
+
+// AES-GCM的nonce: 发送者ID | 时间戳高16位 | 序号
+// 同一频道密钥下各发送者的nonce空间互不重叠；时间戳部分避免发送者ID被重新分配后与旧序号重复
+inline quint64 nonce(const Header &header)
+{
+    return (quint64(header.senderId) << 48)
+         | (quint64(header.timestamp >> 16) << 32)
+         | quint64(header.sequence);
+}
+
+// 计算一帧int16 PCM的音频电平 (-dBov，RMS)
+inline quint8 audioLevel(const qint16 *pcm, int samples)
+{
+    if (samples <= 0) return LEVEL_SILENT;
+
+    double sum = 0.0;
+    for (int i = 0; i < samples; ++i) {
+        double s = pcm[i] / 32768.0;
+        sum += s * s;
+    }
+    double rms = std::sqrt(sum / samples);
+    if (rms <= 0.0) return LEVEL_SILENT;
+
+    double dbov = -20.0 * std::log10(rms);
+    return quint8(qBound(0.0, std::round(dbov), double(LEVEL_SILENT)));
+}
+
+} // namespace VoicePacket
+
+#endif // VOICEPACKET_H
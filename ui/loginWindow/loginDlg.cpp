@@ -14,7 +14,7 @@
 LoginDlg::LoginDlg(QWidget *parent, NetworkClient *networkClient)
     : QDialog(parent), ui(new Ui::LoginDlg),
       m_audioEngine(new AudioEngine(this)), m_networkClient(networkClient),
-      m_localVoicePort(0), m_audioCounter(0) {
+      m_localVoicePort(0) {
   ui->setupUi(this);
 
   // 加载保存的连接设置
@@ -122,7 +122,7 @@ void LoginDlg::onLoginSuccess(quint16 voicePort) {
   QByteArray sessionKey = m_networkClient->getSessionKey();
   if (!sessionKey.isEmpty()) {
     m_audioEngine->setEncryptionKey(sessionKey);
-    m_audioEngine->setAudioCounter(&m_audioCounter);
+    m_audioEngine->setSenderId(m_networkClient->getVoiceId());
     qInfo() << "Encryption enabled for audio";
   }
 
@@ -41,7 +41,6 @@ private:
   NetworkClient *m_networkClient;
   QString m_currentChannel;
   quint16 m_localVoicePort;
-  quint64 m_audioCounter; // 用于音频加密的计数器
 };
 
 #endif // LOGIN_DLG_H
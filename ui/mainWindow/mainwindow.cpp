@@ -14,10 +14,15 @@
 MainWindow::MainWindow(QWidget *parent, NetworkClient *networkClient)
     : QMainWindow(parent), ui(new Ui::MainWindow),
       m_audioEngine(new AudioEngine(this)), m_networkClient(networkClient),
-      m_localVoicePort(networkClient->getUdpPort()), m_audioCounter(0),
+      m_localVoicePort(networkClient->getUdpPort()),
       m_serverIP(networkClient->getServerIP()) {
   ui->setupUi(this);
 
+  // 可选: 音频线程使用实时调度 (需要系统授予实时优先级的权限)
+  QSettings settings("VoicePhone", "VoicePhone");
+  m_audioEngine->setRealtimeScheduling(
+      settings.value("Audio/realtimeScheduling", false).toBool());
+
   // 连接信号
   connect(ui->joinChannelButton, &QPushButton::clicked, this,
           &MainWindow::onJoinChannelClicked);
@@ -37,6 +42,12 @@ MainWindow::MainWindow(QWidget *parent, NetworkClient *networkClient)
           &MainWindow::onJoinedChannel);
   connect(m_networkClient, &NetworkClient::leftChannel, this,
           &MainWindow::onLeftChannel);
+  connect(m_networkClient, &NetworkClient::redirected, this,
+          &MainWindow::onRedirected);
+  connect(m_networkClient, &NetworkClient::connectionInterrupted, this,
+          &MainWindow::onConnectionInterrupted);
+  connect(m_networkClient, &NetworkClient::sessionResumed, this,
+          &MainWindow::onSessionResumed);
   connect(m_networkClient, &NetworkClient::errorOccurred, this,
           &MainWindow::onNetworkError);
 
@@ -107,25 +118,48 @@ void MainWindow::onUserLeft(const QString &username) {
 
 void MainWindow::onJoinedChannel(const QString &channel) {
   m_currentChannel = channel;
-  m_audioCounter = 0; // 重置音频计数器
   ui->statusLabel->setText(
       QString("Status: Joined channel '%1' - Voice connected").arg(channel));
 
+  // 数据包头部携带服务器分配的发送者ID
+  m_audioEngine->setSenderId(m_networkClient->getVoiceId());
+
   // 设置频道加密密钥到音频引擎
   QByteArray channelKey = m_networkClient->getChannelKey();
   if (!channelKey.isEmpty()) {
     m_audioEngine->setEncryptionKey(channelKey);
-    m_audioEngine->setAudioCounter(&m_audioCounter);
     qInfo() << "Audio encryption enabled for channel";
   }
 
-  // 启动音频引擎
+  // 启动音频引擎 (集群重定向后服务器地址和语音端口可能已改变，每次重新获取)
+  m_serverIP = m_networkClient->getServerIP();
   QString serverIp = this->m_serverIP.trimmed();
-  m_audioEngine->start(serverIp, m_localVoicePort, m_localVoicePort);
+  m_audioEngine->start(serverIp, quint16(m_networkClient->getVoicePort()),
+                       m_localVoicePort);
 
   updateUIState();
 }
 
+void MainWindow::onRedirected(const QString &host, quint16 port) {
+  ui->statusLabel->setText(
+      QString("Status: Channel hosted on %1:%2 - Reconnected").arg(host).arg(port));
+}
+
+void MainWindow::onConnectionInterrupted() {
+  // 会话在服务器上保留，音频继续运行
+  ui->statusLabel->setText("Status: Connection lost - Reconnecting...");
+}
+
+void MainWindow::onSessionResumed() {
+  if (m_currentChannel.isEmpty()) {
+    ui->statusLabel->setText("Status: Reconnected");
+  } else {
+    ui->statusLabel->setText(
+        QString("Status: Joined channel '%1' - Reconnected")
+            .arg(m_currentChannel));
+  }
+}
+
 void MainWindow::onLeftChannel() {
   ui->statusLabel->setText(
       QString("Status: Left channel '%1'").arg(m_currentChannel));
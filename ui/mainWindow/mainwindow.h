@@ -30,6 +30,9 @@ private slots:
   void onUserLeft(const QString &username);
   void onJoinedChannel(const QString &channel);
   void onLeftChannel();
+  void onRedirected(const QString &host, quint16 port);
+  void onConnectionInterrupted();
+  void onSessionResumed();
   void onNetworkError(const QString &error);
 
 private:
@@ -40,7 +43,6 @@ private:
   NetworkClient *m_networkClient;
   QString m_currentChannel;
   quint16 m_localVoicePort;
-  quint64 m_audioCounter; // 用于音频加密的计数器
   QString m_serverIP;
 };
 